@@ -0,0 +1,354 @@
+/*
+ * benchmark.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures the speed of the game engine in a few fixed scenarios and
+ * prints the results as JSON, e.g. to compare two revisions:
+ *
+ *   make benchmark > before.json
+ *
+ * As every scenario is generated from a fixed seed, all runs of the same
+ * revision perform exactly the same work.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cJSON.h"
+#include "config.h"
+#include "display.h"
+#include "extdefs.h"
+#include "game.h"
+#include "inventory.h"
+#include "items.h"
+#include "map.h"
+#include "monsters.h"
+#include "pathfinding.h"
+#include "player.h"
+#include "random.h"
+
+/* the measured phases of the game */
+typedef enum _bench_phase
+{
+    BP_TURN,    /* one turn of the game world, see game_spin_the_wheel() */
+    BP_FOV,     /* player_update_fov() */
+    BP_PATH,    /* path_find() to a random destination */
+    BP_PAINT,   /* display_paint_screen() */
+    BP_SAVE,    /* game_save() */
+    BP_LOAD,    /* restoring the saved game */
+    BP_MAX
+} bench_phase;
+
+static const char *bench_phase_names[BP_MAX] =
+{
+    "turn", "fov", "path", "paint", "save", "load"
+};
+
+/* the timings of one phase in microseconds */
+typedef struct _bench_timer
+{
+    guint runs;
+    gint64 total;
+    gint64 min;
+    gint64 max;
+} bench_timer;
+
+typedef struct _bench_scenario
+{
+    const char *name;
+    guint32 seed;
+    void (*setup)(game *g);
+} bench_scenario;
+
+static void bench_setup_town(game *g);
+static void bench_setup_crowd(game *g);
+static void bench_setup_volcano(game *g);
+static void bench_setup_late_game(game *g);
+
+static const bench_scenario scenarios[] =
+{
+    { "quiet_town",  0x4e4c6172, bench_setup_town },
+    { "crowded_d10", 0x4e4c6173, bench_setup_crowd },
+    { "volcano",     0x4e4c6174, bench_setup_volcano },
+    { "late_game",   0x4e4c6175, bench_setup_late_game },
+};
+
+/* command line options */
+static gint bench_turns = 500;
+static gint bench_saves = 10;
+static char *bench_libdir = NULL;
+
+static cJSON *bench_run(const bench_scenario *sc, struct game_config *config);
+static void bench_timer_add(bench_timer *t, gint64 start);
+static cJSON *bench_timer_serialize(bench_timer *t);
+
+int main(int argc, char *argv[])
+{
+    const GOptionEntry entries[] =
+    {
+        { "turns",  'n', 0, G_OPTION_ARG_INT,      &bench_turns,  "Number of turns to play per scenario", NULL },
+        { "saves",  's', 0, G_OPTION_ARG_INT,      &bench_saves,  "Number of saves and loads per scenario", NULL },
+        { "libdir", 'l', 0, G_OPTION_ARG_FILENAME, &bench_libdir, "Directory containing the game's data files", NULL },
+        { NULL, 0, 0, 0, NULL, NULL, NULL }
+    };
+
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new("- measure the speed of the game engine");
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("option parsing failed: %s\n", error->message);
+
+        exit(EXIT_FAILURE);
+    }
+    g_option_context_free(context);
+
+    game_set_libdir(bench_libdir ? bench_libdir : "lib");
+
+    /* never touch the player's saved game */
+    nlarn_savefile = g_build_filename(g_get_tmp_dir(), "nlarn-benchmark.sav", NULL);
+
+    /* the screen is painted, but not shown */
+    display_init(DB_OFFSCREEN);
+
+    cJSON *results = cJSON_CreateObject();
+    cJSON_AddStringToObject(results, "nlarn_version", nlarn_version);
+    cJSON_AddNumberToObject(results, "turns", bench_turns);
+    cJSON_AddNumberToObject(results, "saves", bench_saves);
+
+    cJSON *list = cJSON_CreateArray();
+    cJSON_AddItemToObject(results, "scenarios", list);
+
+    for (guint idx = 0; idx < G_N_ELEMENTS(scenarios); idx++)
+    {
+        /* the config's strings are modified by game_create() */
+        char name[] = "Benchmark";
+        char gender[] = "m";
+        char stats[] = "a";
+        struct game_config config = { 0 };
+
+        config.name = name;
+        config.gender = gender;
+        config.stats = stats;
+        config.no_autosave = TRUE;
+
+        /* wizard mode keeps the player alive */
+        config.wizard = TRUE;
+
+        cJSON_AddItemToArray(list, bench_run(&scenarios[idx], &config));
+    }
+
+    display_shutdown();
+    game_delete_savefile();
+
+    char *out = cJSON_Print(results);
+    puts(out);
+
+    free(out);
+    cJSON_Delete(results);
+
+    return EXIT_SUCCESS;
+}
+
+static cJSON *bench_run(const bench_scenario *sc, struct game_config *config)
+{
+    bench_timer timers[BP_MAX] = { { 0, 0, 0, 0 } };
+    gint64 start;
+
+    game *g = game_create(config, sc->seed);
+    sc->setup(g);
+
+    player *p = g->p;
+    player_update_fov(p);
+    display_map_invalidate();
+
+    if (setjmp(nlarn_death_jump) != PD_NONE)
+    {
+        /* even wizards can't survive everything */
+        display_shutdown();
+        g_printerr("The player died in scenario \"%s\".\n", sc->name);
+        exit(EXIT_FAILURE);
+    }
+
+    for (int turn = 0; turn < bench_turns; turn++)
+    {
+        map *m = game_map(g, Z(p->pos));
+        position goal = map_find_space(m, LE_GROUND, FALSE);
+
+        start = g_get_monotonic_time();
+        player_make_move(p, 1, FALSE, NULL);
+        bench_timer_add(&timers[BP_TURN], start);
+
+        start = g_get_monotonic_time();
+        player_update_fov(p);
+        bench_timer_add(&timers[BP_FOV], start);
+
+        start = g_get_monotonic_time();
+        path *path = path_find(m, p->pos, goal, LE_GROUND);
+        bench_timer_add(&timers[BP_PATH], start);
+
+        if (path != NULL)
+            path_destroy(path);
+
+        start = g_get_monotonic_time();
+        display_paint_screen(p);
+        bench_timer_add(&timers[BP_PAINT], start);
+    }
+
+    for (int run = 0; run < bench_saves; run++)
+    {
+        start = g_get_monotonic_time();
+        game_save(g);
+        bench_timer_add(&timers[BP_SAVE], start);
+
+        start = g_get_monotonic_time();
+        game_init(config);
+        bench_timer_add(&timers[BP_LOAD], start);
+
+        /* drop the restored game and continue with the original one */
+        game_destroy(nlarn);
+        game_set_current(g);
+    }
+
+    cJSON *res = cJSON_CreateObject();
+    cJSON_AddStringToObject(res, "name", sc->name);
+    cJSON_AddNumberToObject(res, "seed", sc->seed);
+    cJSON_AddNumberToObject(res, "monsters", g_hash_table_size(g->monsters));
+    cJSON_AddNumberToObject(res, "items", g_hash_table_size(g->items));
+    cJSON_AddNumberToObject(res, "turns_per_second", timers[BP_TURN].total
+                            ? timers[BP_TURN].runs * 1000000.0 / timers[BP_TURN].total
+                            : 0);
+
+    cJSON *phases = cJSON_CreateObject();
+    cJSON_AddItemToObject(res, "phases", phases);
+
+    for (bench_phase ph = 0; ph < BP_MAX; ph++)
+    {
+        cJSON_AddItemToObject(phases, bench_phase_names[ph],
+                              bench_timer_serialize(&timers[ph]));
+    }
+
+    game_destroy(g);
+
+    return res;
+}
+
+static void bench_timer_add(bench_timer *t, gint64 start)
+{
+    gint64 duration = g_get_monotonic_time() - start;
+
+    if (t->runs == 0 || duration < t->min)
+        t->min = duration;
+
+    if (duration > t->max)
+        t->max = duration;
+
+    t->runs++;
+    t->total += duration;
+}
+
+static cJSON *bench_timer_serialize(bench_timer *t)
+{
+    cJSON *tser = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(tser, "runs", t->runs);
+    cJSON_AddNumberToObject(tser, "total_us", t->total);
+    cJSON_AddNumberToObject(tser, "mean_us", t->runs ? (double)t->total / t->runs : 0);
+    cJSON_AddNumberToObject(tser, "min_us", t->min);
+    cJSON_AddNumberToObject(tser, "max_us", t->max);
+
+    return tser;
+}
+
+static void bench_setup_town(game *g)
+{
+    /* a new game starts in the town */
+    (void)g;
+}
+
+static void bench_setup_crowd(game *g)
+{
+    map *m = game_map(g, 10);
+
+    player_map_enter(g->p, m, FALSE);
+    player_level_gain(g->p, 10);
+
+    /* fill the level with monsters */
+    for (int count = 0; count < 80; count++)
+    {
+        position pos = map_find_space(m, LE_MONSTER, FALSE);
+
+        if (pos_valid(pos))
+            monster_new_by_level(pos);
+    }
+}
+
+static void bench_setup_volcano(game *g)
+{
+    map *m = game_map(g, MAP_MAX - 1);
+
+    player_map_enter(g->p, m, FALSE);
+    player_level_gain(g->p, 20);
+
+    /* set large parts of the level on fire and fill others with gas */
+    for (int count = 0; count < 40; count++)
+    {
+        position pos = map_find_space(m, LE_GROUND, FALSE);
+
+        if (!pos_valid(pos))
+            continue;
+
+        area obstacles, range;
+
+        map_get_obstacles(m, pos, 4, FALSE, &obstacles);
+        area_init_circle_flooded(&range, pos, 4, &obstacles);
+
+        map_set_tiletype(m, &range, (count % 2) ? LT_FIRE : LT_CLOUD, 255);
+    }
+}
+
+static void bench_setup_late_game(game *g)
+{
+    const item_t types[] =
+    {
+        IT_AMULET, IT_AMMO, IT_ARMOUR, IT_BOOK, IT_GEM,
+        IT_POTION, IT_RING, IT_SCROLL, IT_WEAPON
+    };
+
+    player *p = g->p;
+
+    player_map_enter(p, game_map(g, MAP_CMAX - 1), FALSE);
+    player_level_gain(p, 25);
+
+    /* a strong character carrying lots of stuff */
+    p->strength = 100;
+
+    for (int count = 0; count < 400; count++)
+    {
+        item *it = item_new_by_level(types[count % G_N_ELEMENTS(types)],
+                                     rand_1n(MAP_MAX));
+
+        /* what the player can't carry has been stored at home */
+        if (!inv_add(&p->inventory, it))
+            inv_add(&g->player_home, it);
+    }
+}
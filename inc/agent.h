@@ -0,0 +1,116 @@
+/*
+ * agent.h
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A programming interface to play the game without the terminal, e.g.
+ * for bots and automated balance tests. It is part of libnlarn.a.
+ *
+ * Each thread plays its own game. Before the first game is started,
+ * game_set_libdir() has to be called to locate the game's data files.
+ */
+
+#ifndef __AGENT_H_
+#define __AGENT_H_
+
+#include <glib.h>
+
+#include "map.h"
+#include "monsters.h"
+#include "player.h"
+#include "position.h"
+
+/* the actions available to agents */
+typedef enum _agent_action
+{
+    AA_WAIT,
+    AA_MOVE_SW,
+    AA_MOVE_S,
+    AA_MOVE_SE,
+    AA_MOVE_W,
+    AA_MOVE_E,
+    AA_MOVE_NW,
+    AA_MOVE_N,
+    AA_MOVE_NE,
+    AA_PICKUP,
+    AA_STAIRS_DOWN,
+    AA_STAIRS_UP,
+    AA_MAX
+} agent_action;
+
+/* a monster the player can see */
+typedef struct _agent_monster
+{
+    monster_t type;
+    position pos;
+} agent_monster;
+
+/* what the player knows after an action */
+typedef struct _agent_observation
+{
+    /* the player's memory of the current map */
+    char map[MAP_MAX_Y][MAP_MAX_X];
+
+    position pos;       /* the player's position */
+    guint32 turn;       /* the game time */
+    gint hp;
+    guint hp_max;
+    gint mp;
+    guint mp_max;
+    guint level;        /* experience level */
+    guint experience;
+    guint gold;         /* carried gold */
+
+    GArray *monsters;   /* visible monsters (agent_monster), nearest first */
+    GPtrArray *messages; /* messages of the turns passed since the last call */
+
+    gboolean done;      /* the game has ended */
+    player_cod cause;   /* the reason the game has ended */
+} agent_observation;
+
+/**
+ * @brief Start a new game for the calling thread.
+ *
+ * A game previously started by the thread is destroyed. Games started
+ * with the same seed and played with the same actions develop identically.
+ *
+ * @param The seed of the game's random number generator.
+ * @return The initial observation, valid until the next call.
+ */
+const agent_observation *nlarn_reset(guint32 seed);
+
+/**
+ * @brief Perform an action in the game of the calling thread.
+ *
+ * @param The action.
+ * @return The resulting observation, valid until the next call.
+ */
+const agent_observation *nlarn_step(agent_action action);
+
+/**
+ * @brief Check if the game of the calling thread has ended.
+ *
+ * @return TRUE if there is no game to continue.
+ */
+gboolean nlarn_done();
+
+/**
+ * @brief Destroy the game of the calling thread and the last observation.
+ */
+void nlarn_close();
+
+#endif
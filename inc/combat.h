@@ -134,13 +134,15 @@ typedef struct _damage_msg
     char *msg_unaffected;
 } damage_msg;
 
-damage *damage_new(damage_t type, attack_t att_type, int amount,
-                   damage_originator_t damo, gpointer originator);
-
-damage *damage_copy(damage *dam);
+/* damages are small values: they are kept on the stack and passed by value */
+static inline damage damage_new(damage_t type, attack_t att_type, int amount,
+                                damage_originator_t damo, gpointer originator)
+{
+    damage dam = { type, att_type, amount, { damo, originator } };
 
-static inline void damage_free(damage *dam) { g_free(dam); }
+    return dam;
+}
 
-char *damage_to_str(damage *dam);
+char *damage_to_str(const damage *dam);
 
 #endif
@@ -24,6 +24,13 @@ struct game_config {
     gint difficulty;
     gboolean wizard;
     gboolean no_autosave;
+    gboolean headless;
+    char *record;       /* file to record the game to */
+    char *replay;       /* recorded game to play back */
+    gint replay_turn;   /* fast-forward the recorded game to this turn */
+    char *profile_out;  /* file to write the profiling data to */
+    char *trace;        /* file to write the trace of the game's functions to */
+    char *mem_report;   /* file to write the memory use to */
     char *name;
     char *gender;
     char *auto_pickup;
@@ -125,9 +125,17 @@ typedef struct display_window
     PANEL *panel;
 } display_window;
 
+/* the available display backends */
+typedef enum _display_backend
+{
+    DB_CURSES,    /* draw the game on the terminal */
+    DB_NULL,      /* draw nothing, don't pause, read keys from stdin */
+    DB_OFFSCREEN, /* like DB_NULL, but paint into curses' buffers */
+} display_backend;
+
 /* function declarations */
 
-void display_init();
+void display_init(display_backend backend);
 void display_shutdown();
 
 /**
@@ -143,6 +151,72 @@ void display_draw();
 
 void display_paint_screen(player *p);
 
+/**
+ * @brief Repaint the entire map on the next call of display_paint_screen().
+ *
+ * Only the map cells that have changed since the last call are written
+ * to the screen. This has to be called after painting over the map.
+ */
+void display_map_invalidate();
+
+/**
+ * @brief Paint a single glyph over the map, e.g. a flying projectile.
+ *
+ * @param The position on the map.
+ * @param The glyph to paint.
+ * @param The curses attributes to use.
+ */
+void display_paint_glyph(position pos, char glyph, int attrs);
+
+/**
+ * @brief Paint the area affected by a blast over the map.
+ *
+ * Stationary objects, visible monsters and the player remain visible,
+ * all other cells show the glyph of the blast.
+ *
+ * @param The map the blast happens on.
+ * @param The area covered by the blast.
+ * @param The glyph to paint.
+ * @param The curses attributes to use.
+ */
+void display_paint_blast(map *m, const area *blast, char glyph, int attrs);
+
+/**
+ * @brief Pause to allow the player to see an animation.
+ *
+ * @param The duration in milliseconds. Ignored by the headless displays.
+ */
+void display_delay(int ms);
+
+/**
+ * @brief Discard all keys pressed but not yet read.
+ */
+void display_flush_input();
+
+/**
+ * @brief Stop or resume painting, e.g. while fast-forwarding a replay.
+ *
+ * @param TRUE to stop painting, FALSE to resume.
+ */
+void display_suspend(gboolean suspend);
+
+/**
+ * @brief Get a small number representing a colour, e.g. to store the
+ *        colour compactly. The number fits into five bits.
+ *
+ * @param One of the display_default_colours.
+ * @return The number of the colour; 0 for unknown colours.
+ */
+guint display_colour_index(int colour);
+
+/**
+ * @brief Get the colour represented by a number.
+ *
+ * @param A value returned by display_colour_index().
+ * @return The colour.
+ */
+int display_colour_at(guint index);
+
 /**
  * Generic inventory display function
  *
@@ -135,8 +135,16 @@ typedef struct effect
     guint32 turns;      /* number of turns this effect remains */
     gint32 amount;      /* power of effect, if applicable */
     gpointer item;      /* oid of item which causes the effect (if caused by item) */
+    guint32 scheduled;  /* game time of the pending expiry timer (not saved) */
 } effect;
 
+/* per-type summary of the effects of a player or a monster */
+typedef struct effect_summary
+{
+    gint32 amount[ET_MAX];                  /* total amount of all effects of a type */
+    guint32 active[(ET_MAX + 31) / 32];     /* set if an effect not caused by an item is present */
+} effect_summary;
+
 struct game;
 
 /* function declarations */
@@ -155,6 +163,7 @@ guint effect_type_duration(effect_t type);
 int effect_type_amount(effect_t type);
 gboolean effect_type_inc_duration(effect_t type);
 gboolean effect_type_inc_amount(effect_t type);
+gboolean effect_type_countdown(effect_t type);
 const char *effect_get_desc(effect *e);
 const char *effect_get_msg_start(effect *e);
 const char *effect_get_msg_stop(effect *e);
@@ -170,12 +179,79 @@ effect *effect_get(GPtrArray *ea, effect_t type);
 /* check if an effect is set */
 int effect_query(GPtrArray *ea, effect_t type);
 
+/**
+ * @brief Recalculate the summary entry for an effect type.
+ *
+ * Has to be called whenever an effect of the given type has been added to,
+ * removed from or modified in the effect array.
+ *
+ * @param The effect summary to update.
+ * @param The effect array the summary belongs to.
+ * @param The effect type which has been changed.
+ */
+void effect_summary_update(effect_summary *es, GPtrArray *ea, effect_t type);
+
+/**
+ * @brief Recalculate the entire summary for an effect array.
+ *
+ * @param The effect summary to fill.
+ * @param The effect array the summary belongs to.
+ */
+void effect_summary_rebuild(effect_summary *es, GPtrArray *ea);
+
+/**
+ * @brief Get the total amount of all effects of a type from a summary.
+ */
+static inline int effect_summary_amount(const effect_summary *es, effect_t type)
+{
+    return es->amount[type];
+}
+
+/**
+ * @brief Check if an effect of a type not caused by an item is present.
+ */
+static inline gboolean effect_summary_active(const effect_summary *es, effect_t type)
+{
+    return (es->active[type / 32] >> (type % 32)) & 1;
+}
+
 /**
  * Count down the number of turns remaining for an effect.
  *
+ * Only applicable to effects which are not bound to the game time,
+ * see effect_type_countdown().
+ *
  * @param an effect
  * @return turns remaining. Expired effects return -1, permantent effects 0
  */
 int effect_expire(effect *e);
 
+/**
+ * @brief Determine the number of turns an effect will last.
+ *
+ * @param an effect
+ * @return turns remaining. Permanent effects return 0, expired effects
+ *         zero or less.
+ */
+int effect_turns_left(effect *e);
+
+/**
+ * @brief Schedule the expiry of an effect.
+ *
+ * Has to be called whenever an effect has been attached to a player or a
+ * monster and whenever the duration of an attached effect has changed.
+ * Permanent effects and effects that are counted down are ignored.
+ *
+ * @param an effect
+ * @param the oid of the monster the effect belongs to or NULL for the player
+ */
+void effect_schedule(effect *e, gpointer owner);
+
+/**
+ * @brief Expire all effects which have timed out until the current game turn.
+ *
+ * @param the game
+ */
+void effects_expire(struct game *g);
+
 #endif
@@ -27,11 +27,11 @@
 /* game version string */
 extern const char *nlarn_version;
 
-/* the entire game */
-extern game *nlarn;
+/* the game the thread is working on */
+extern THREAD_LOCAL game *nlarn;
 
 /* death jump buffer - used to return to the main loop when the player has died */
-extern jmp_buf nlarn_death_jump;
+extern THREAD_LOCAL jmp_buf nlarn_death_jump;
 
 /* file paths */
 extern const char *nlarn_libdir;
@@ -23,12 +23,34 @@
 #include "items.h"
 #include "map.h"
 #include "player.h"
+#include "pqueue.h"
+#include "random.h"
 #include "spheres.h"
+#include "timewheel.h"
 
 #define TIMELIMIT 30000 /* maximum number of moves before the game is called */
 
 /* internal counter for save file compatibility */
-#define SAVEFILE_VERSION    26
+#define SAVEFILE_VERSION    28
+
+/*
+ * Several games can exist at once, each thread working on its current game
+ * (see game_set_current()). The following state is not part of a game but
+ * shared by the entire process, which restricts how games can be used:
+ *
+ * - The save file (nlarn_savefile) and the lock on it. game_save(),
+ *   game_init() and game_delete_savefile() always use this one file, so only
+ *   one thread at a time may save or restore a game; games created by
+ *   game_create() are not saved unless the caller does so explicitly.
+ * - The display (display.c), including the frame last painted to the screen.
+ *   It mirrors the one terminal, so only one thread may paint or read keys.
+ *   Other threads have to run their games with the DB_NULL backend.
+ * - The recording or playback of keys (replay.c), which belongs to the
+ *   interactive game reading keys from the display.
+ * - The names of the files written by the profiler and its trace file
+ *   (profile.c). The counters are kept per thread and the trace is written
+ *   under a lock, so every thread may be profiled.
+ */
 
 /* the world as we know it */
 typedef struct game
@@ -40,6 +62,7 @@ typedef struct game
     guint32 gtime;              /* turn count */
     guint8 difficulty;          /* game difficulty */
     message_log *log;           /* game message log */
+    rng_state rng;              /* the game's random number generator */
 
     /* stock of the dnd store */
     inventory *store_stock;
@@ -54,6 +77,7 @@ typedef struct game
     int armour_created[AT_MAX];
     int weapon_created[WT_MAX];
     int monster_genocided[MT_MAX];
+    gboolean maze_used[MAP_MAZE_NUM + 1]; /* mazes already used by this game */
 
     /* Item obfuscation mappings */
     int amulet_material_mapping[AM_MAX];
@@ -62,12 +86,33 @@ typedef struct game
     int scroll_desc_mapping[ST_MAX];
     int book_desc_mapping[SP_MAX];
 
+    /* the properties of all item types and ids, see item_properties_init() */
+    item_properties *item_props;
+
+    /* the last description of each item, see item_describe() */
+    GHashTable *item_desc_memos;
+
+    /* Samplers of the monster types for the possible ranges of levels
+       (see monster_new_by_level()), of the monster types available for
+       polymorphing and of the ids of new armour and weapons. They are
+       built when needed and dropped when genocide or the creation of
+       unique items changes the available choices. */
+    rand_alias *monster_samplers[MAP_MAX][MAP_MAX];
+    rand_alias *polymorph_sampler;
+    rand_alias *armour_sampler;
+    rand_alias *weapon_sampler;
+
     /* these are the item ids assigned to new objects of the latter types */
 
     guint item_max_id;
     guint effect_max_id;
     guint monster_max_id;
 
+    /* Incremented whenever the count of an item has been modified outside
+       of inventory.c. The cached weight of an inventory is valid only for
+       the generation it has been calculated for. */
+    guint32 item_generation;
+
     /* every object of the types item, effect and monster will be registered
        in these hashed when created and unregistered when destroyed. */
 
@@ -83,6 +128,18 @@ typedef struct game
      */
     GPtrArray *dead_monsters;
 
+    /* The monsters that will be moved during the current turn. */
+    GPtrArray *active_monsters;
+
+    /* The moves of the active monsters, ordered by their time in the turn. */
+    pqueue *monster_moves;
+
+    /* The number of monster moves the player could see during the last turn. */
+    guint visible_moves;
+
+    /* pending expiry of effects, ordered by game time */
+    timewheel *effect_timers;
+
     /* spheres do not need to be referenced, thus a pointer array is sufficient */
     GPtrArray *spheres;
 
@@ -103,6 +160,13 @@ struct game_config;
 
 /* function declarations */
 
+/**
+ * @brief Set the directory containing the game's data files.
+ *
+ * @param The library directory
+ */
+void game_set_libdir(const char *libdir);
+
 /**
  * @brief Initialise the game. This function will try to restore a saved game;
  *        if it fails it will start a new game.
@@ -111,6 +175,28 @@ struct game_config;
  */
 void game_init(struct game_config *config);
 
+/**
+ * @brief Start a new game without touching the save file.
+ *
+ * Any number of games can exist at once. The new game becomes the
+ * current game of the calling thread.
+ *
+ * @param pointer to a parsed command line configuration
+ * @param the seed of the game's random number generator
+ * @return the new game
+ */
+game *game_create(struct game_config *config, guint32 seed);
+
+/**
+ * @brief Select the game the calling thread is working on.
+ *
+ * Each thread has its own current game, which is referred to by nlarn.
+ * Its random number generator is selected as well.
+ *
+ * @param The game to continue. May be NULL.
+ */
+void game_set_current(game *g);
+
 game *game_destroy(game *g);
 
 /**
@@ -37,6 +37,13 @@ typedef struct _inventory
     inv_callback_void post_del;
     gconstpointer owner;
     GPtrArray *content;
+    GHashTable *stacks; /* stackable items by type and id, built on demand */
+
+    /* cached values, built on demand */
+    guint type_count[IT_MAX];   /* number of items of each type */
+    int weight;                 /* weight of all items except containers */
+    guint32 weight_gen;         /* item generation the weight is valid for */
+    gboolean counted;           /* type_count has been filled */
 } inventory;
 
 /* function definitions */
@@ -118,6 +125,19 @@ int inv_del_element(inventory **inv, item *it);
  */
 int inv_del_oid(inventory **inv, gpointer oid);
 
+/**
+ * Change the id of an item inside an inventory.
+ *
+ * Keeps the inventory's index of stackable items up to date, which is keyed
+ * by item type and id.
+ *
+ * @param the inventory containing the item
+ * @param the item
+ * @param the new id of the item
+ *
+ */
+void inv_item_rekey(inventory *inv, item *it, guint id);
+
 /**
  * Erode all items in an inventory.
  *
@@ -158,6 +178,36 @@ void inv_sort(inventory *inv, GCompareDataFunc compare_func, gpointer user_data)
  */
 int inv_weight(inventory *inv);
 
+/**
+ * Notify the inventories that the weight of an item has been modified.
+ *
+ * Has to be called whenever the count (or anything else that determines
+ * the weight) of an item which lies in an inventory is modified. This
+ * invalidates the cached weight of all inventories.
+ */
+void inv_items_changed();
+
+/**
+ * Count the items of a type in an inventory.
+ *
+ * @param the inventory to look in
+ * @param the item type
+ * @return the number of items of the given type
+ *
+ */
+guint inv_length_type(inventory *inv, item_t type);
+
+/**
+ * Get an item of a type from an inventory.
+ *
+ * @param the inventory to look in
+ * @param the index of the item among the items of the given type
+ * @param the item type
+ * @return the item or NULL if there is no such item
+ *
+ */
+item *inv_get_type(inventory *inv, guint idx, item_t type);
+
 /**
  * Count an filtered inventory.
  *
@@ -87,6 +87,7 @@ typedef enum item_erosion_t {
 
 struct game;
 struct _inventory;
+struct player;
 
 typedef struct _item {
     gpointer oid;           /* item's game object id */
@@ -108,6 +109,17 @@ typedef struct _item {
         fired: 1;           /* player has fired the item */
 } item;
 
+/* the properties shared by all items of the same type and id */
+typedef struct _item_properties {
+    guint32 price;          /* for gems: the price per carat */
+    guint32 weight;         /* of a single item; not used for gems */
+    item_material_t material;
+    int colour;
+    guint32
+        fragility: 7,       /* chance to break of an undamaged item */
+        unbreakable: 1;
+} item_properties;
+
 typedef struct item_type_data {
     item_t id;
     const char *name_sg;
@@ -146,7 +158,14 @@ item *item_deserialize(cJSON *iser, struct game *g);
  */
 int item_compare(item *a, item *b);
 
-int item_sort(gconstpointer a, gconstpointer b, gpointer data, gboolean force_id);
+/**
+ * Sort the items in an inventory by type and name.
+ *
+ * @param the inventory to be sorted
+ * @param the player whose knowledge determines the names
+ * @param TRUE if the true names of all items shall be used
+ */
+void item_sort(struct _inventory *inv, struct player *p, gboolean force_id);
 
 /**
  * Describe an item.
@@ -160,6 +179,14 @@ int item_sort(gconstpointer a, gconstpointer b, gpointer data, gboolean force_id
  */
 gchar *item_describe(item *it, gboolean known, gboolean singular, gboolean definite);
 
+/**
+ * @brief Fill the current game's table of item properties.
+ *
+ * Has to be called whenever the item obfuscation mappings of the game
+ * have been modified.
+ */
+void item_properties_init();
+
 item_material_t item_material(item *it);
 guint item_base_price(item *it);
 guint item_price(item *it);
@@ -27,9 +27,7 @@
 #include "traps.h"
 #include "utils.h"
 
-/* map dimensions */
-#define MAP_MAX_X 67
-#define MAP_MAX_Y 17
+/* map dimensions (MAP_MAX_X and MAP_MAX_Y are defined in position.h) */
 #define MAP_SIZE MAP_MAX_X*MAP_MAX_Y
 
 /* number of levels */
@@ -99,12 +97,23 @@ typedef struct map
     guint32 nlevel;                       /* map number */
     guint32 visited;                      /* last time player has been on this map */
     guint32 mcount;                       /* monster count */
+    monster *mfirst;                      /* first monster on this map */
+    monster *mlast;                       /* last monster on this map */
     map_tile grid[MAP_MAX_Y][MAP_MAX_X];  /* the map */
 } map;
 
-/* callback function for trajectories */
-typedef gboolean (*trajectory_hit_sth)(const GList *trajectory,
-        const damage_originator *damo,
+/* the positions of a ray; a ray has at most max(|dx|, |dy|) + 1 points,
+   which never exceeds MAP_MAX_X as MAP_MAX_Y is smaller */
+typedef struct _position_span
+{
+    guint len;
+    position pos[MAP_MAX_X];
+} position_span;
+
+/* callback function for trajectories; the affected position is
+   trajectory->pos[idx] */
+typedef gboolean (*trajectory_hit_sth)(const position_span *trajectory,
+        guint idx, const damage_originator *damo,
         gpointer data1, gpointer data2);
 
 /* function declarations */
@@ -146,13 +155,16 @@ int *map_get_surrounding(map *m, position pos, sobject_t type);
 int map_pos_is_visible(map *m, position source, position target);
 
 /**
- * Return a linked list with every position between two points.
+ * Determine every position between two points. The ray ends at the first
+ * position that is not transparent.
  *
  * @param The map that contains both positions.
  * @param The starting position.
  * @param The destination.
+ * @param The ray to fill, beginning with the starting position.
+ * @return TRUE if the ray reaches the destination.
  */
-GList *map_ray(map *m, position source, position target);
+gboolean map_ray(map *m, position source, position target, position_span *ray);
 
 /**
  * Follow a ray from target to destination.
@@ -183,14 +195,23 @@ gboolean map_trajectory(position source, position target,
  * @param The center position.
  * @param The radius.
  * @param Shall closed doors be handled as passable?
- *
- * @return A freshly allocated area with all impassable positions set.
+ * @param The area to initialise with all impassable positions set.
  */
-area *map_get_obstacles(map *m, position center, int radius, gboolean doors);
+void map_get_obstacles(map *m, position center, int radius, gboolean doors,
+                       area *obstacles);
 
-void map_set_tiletype(map *m, area *area, map_tile_t type, guint8 duration);
+void map_set_tiletype(map *m, const area *area, map_tile_t type, guint8 duration);
 
-damage *map_tile_damage(map *m, position pos, gboolean flying);
+/**
+ * @brief Determine the damage caused by the tile at a position.
+ *
+ * @param A map.
+ * @param The position.
+ * @param Is the affected creature flying?
+ * @param The damage to fill in.
+ * @return TRUE if the tile causes damage.
+ */
+gboolean map_tile_damage(map *m, position pos, gboolean flying, damage *dam);
 
 /**
  * @brief Creates description of items on the floor for a given position.
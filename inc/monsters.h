@@ -135,6 +135,9 @@ typedef enum monster_action_type
     MA_CIVILIAN,
 } monster_action_t;
 
+/* descriptions of the monster actions */
+extern const char *monster_ai_desc[];
+
 #define MONSTER_FLAG_ENUM(MF) \
     MF(HEAD         , = 1)       /* has a head */ \
     MF(NOBEHEAD     , = 1 << 1)  /* cannot be beheaded */ \
@@ -208,7 +211,51 @@ const char* monster_type_plural_name(monster_t mt, const int count);
 void monster_die(monster *m, struct player *p);
 
 void monster_level_enter(monster *m, struct map *l);
-void monster_move(gpointer *oid, monster *m, struct game *g);
+
+/**
+ * @brief Handle everything that happens to a monster once per turn and
+ *        add the monster's speed to its movement points.
+ *
+ * @param A monster.
+ * @param The game.
+ * @return FALSE if the monster died or can not act during this turn.
+ */
+gboolean monster_turn_begin(monster *m, struct game *g);
+
+/**
+ * @brief Determine when a monster will make its next move during this turn.
+ *
+ * @param A monster.
+ * @return The time of the next move in hundredths of a turn (0 to NORMAL)
+ *         or -1 if the monster has no movement points left.
+ */
+int monster_wakeup(monster *m);
+
+/**
+ * @brief Let a monster make a single move.
+ *
+ * @param A monster.
+ * @param The game.
+ * @return FALSE if the monster's turn is over.
+ */
+gboolean monster_act(monster *m, struct game *g);
+
+/**
+ * @brief Finish a turn of a monster which has used all its movement points.
+ *
+ * @param A monster.
+ */
+void monster_turn_end(monster *m);
+
+/**
+ * @brief Get the monster following a given monster on its map.
+ *
+ * Monsters are kept in the order they have been placed on the map.
+ *
+ * @param A monster.
+ * @return The next monster on the same map or NULL.
+ */
+monster *monster_map_next(monster *m);
 
 void monster_polymorph(monster *m);
 
@@ -244,10 +291,10 @@ int monster_player_ranged_attack(monster *m, struct player *p);
  * Deal damage to a monster
  *
  * @param monster
- * @param pointer to the damage to be dealt (will be free'd)
+ * @param the damage to be dealt
  * @return the monster if it has survived, othewise NULL
  */
-monster *monster_damage_take(monster *m, damage *dam);
+monster *monster_damage_take(monster *m, damage dam);
 
 /**
  * Determine a monster's action.
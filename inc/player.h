@@ -84,15 +84,29 @@ typedef struct _player_settings
     gboolean auto_pickup[IT_MAX]; /* automatically pick up item of enabled types */
 } player_settings;
 
+/* the player's memory of a map tile, packed into 32 bits */
 typedef struct _player_tile_memory
 {
-    map_tile_t type;
-    sobject_t sobject;
-    item_t item;            /* type of item located here */
-    int item_colour;        /* colour of item located here */
-    trap_t trap;
+    guint32 type: 4;        /* map_tile_t */
+    guint32 sobject: 6;     /* sobject_t */
+    guint32 item: 4;        /* type of item located here */
+    guint32 item_colour: 5; /* colour of item located here, see display_colour_index() */
+    guint32 trap: 4;        /* trap_t */
 } player_tile_memory;
 
+/* modifiers of the player's attributes caused by effects and equipment */
+typedef struct _player_modifiers
+{
+    gboolean valid; /* cleared by player_modifiers_invalidate() */
+    gint ac;
+    gint strength;
+    gint intelligence;
+    gint wisdom;
+    gint constitution;
+    gint dexterity;
+    gint speed;
+} player_modifiers;
+
 typedef struct _player_sobject_memory
 {
     position pos;
@@ -128,8 +142,11 @@ typedef struct player
 
     /* other stuff */
     GPtrArray *known_spells;
+    spell *last_spell; /* the last cast spell, one of the known spells */
     inventory *inventory;
     GPtrArray *effects; /* temporary effects from potions, spells, ... */
+    effect_summary esummary; /* per-type summary of the effects above */
+    player_modifiers mods; /* derived from the effects and the worn armour */
 
     /* pointers to elements of items which are currently equipped */
     item *eq_amulet;
@@ -167,8 +184,8 @@ typedef struct player
     /* player's field of vision */
     fov *fv;
 
-    /* player's memory of the map */
-    player_tile_memory memory[MAP_MAX][MAP_MAX_Y][MAP_MAX_X];
+    /* player's memory of the maps; allocated on the first visit of a map */
+    player_tile_memory *memory[MAP_MAX];
 
     /* remembered positions of stationary objects */
     GArray *sobjmem;
@@ -290,11 +307,11 @@ int player_hp_lose(player *p, int count, player_cod cause_type, int cause);
  * Inflict damage upon the player
  *
  * @param the player
- * @param pointer to the damage (will be freed)
+ * @param the damage
  * @param of the damage originator
  * @param the id of the damage originator, specific to the damage originator
  */
-void player_damage_take(player *p, damage *dam, player_cod cause_type, int cause);
+void player_damage_take(player *p, damage dam, player_cod cause_type, int cause);
 
 int player_hp_max_gain(player *p, int count);
 int player_hp_max_lose(player *p, int count);
@@ -422,17 +439,10 @@ void player_equip(player *p);
 void player_take_off(player *p);
 void player_drop(player *p);
 
-/* query values */
-guint player_get_ac(player *p);
+/* query values, see also the inline functions below */
 int player_get_hp_max(player *p);
 int player_get_mp_max(player *p);
-int player_get_str(player *p);
-int player_get_int(player *p);
-int player_get_wis(player *p);
-int player_get_con(player *p);
-int player_get_dex(player *p);
 int player_get_cha(player *p);
-int player_get_speed(player *p);
 
 /* deal with money */
 guint player_get_gold(player *p);
@@ -469,8 +479,92 @@ gboolean player_adjacent_monster(player *p, gboolean ignore_harmless);
 /* fighting simulation */
 void calc_fighting_stats(player *p);
 
+/**
+ * @brief Allocate the player's memory of a map.
+ *
+ * @param The player.
+ * @param The number of the map.
+ * @return The memory of all positions of the map.
+ */
+player_tile_memory *player_memory_new(player *p, int nlevel);
+
+static inline player_tile_memory *player_memory_at(player *p, position pos)
+{
+    player_tile_memory *mem = p->memory[Z(pos)];
+
+    if (G_UNLIKELY(mem == NULL))
+        mem = player_memory_new(p, Z(pos));
+
+    return &mem[Y(pos) * MAP_MAX_X + X(pos)];
+}
+
+/**
+ * @brief Recalculate the modifiers of the player's attributes.
+ *
+ * @param The player.
+ */
+void player_modifiers_update(player *p);
+
+/**
+ * @brief Mark the modifiers of the player's attributes as outdated.
+ *
+ * Has to be called whenever the player's effects or the worn armour, including
+ * the condition of a worn piece of armour, have been changed.
+ *
+ * @param The player.
+ */
+static inline void player_modifiers_invalidate(player *p)
+{
+    p->mods.valid = FALSE;
+}
+
+static inline const player_modifiers *player_modifiers_get(player *p)
+{
+    g_assert(p != NULL);
+
+    if (G_UNLIKELY(!p->mods.valid))
+        player_modifiers_update(p);
+
+    return &p->mods;
+}
+
+static inline guint player_get_ac(player *p)
+{
+    return player_modifiers_get(p)->ac;
+}
+
+static inline int player_get_str(player *p)
+{
+    return p->strength + player_modifiers_get(p)->strength;
+}
+
+static inline int player_get_int(player *p)
+{
+    return p->intelligence + player_modifiers_get(p)->intelligence;
+}
+
+static inline int player_get_wis(player *p)
+{
+    return p->wisdom + player_modifiers_get(p)->wisdom;
+}
+
+static inline int player_get_con(player *p)
+{
+    return p->constitution + player_modifiers_get(p)->constitution;
+}
+
+static inline int player_get_dex(player *p)
+{
+    return p->dexterity + player_modifiers_get(p)->dexterity;
+}
+
+static inline int player_get_speed(player *p)
+{
+    return p->speed + player_modifiers_get(p)->speed;
+}
+
 /* macros */
 
-#define player_memory_of(p,pos) ((p)->memory[Z(pos)][Y(pos)][X(pos)])
+#define player_memory_of(p,pos) (*player_memory_at((p), (pos)))
 
 #endif
@@ -60,13 +60,25 @@ typedef struct _rectangle
     guint64 y2: 16;
 } rectangle;
 
+/* map dimensions */
+#define MAP_MAX_X 67
+#define MAP_MAX_Y 17
+
+/* an area is a bit mask covering the entire map */
+#define AREA_WORDS ((MAP_MAX_X + 63) / 64)
+
+/* the largest radius of the memoized circular areas */
+#define AREA_MAX_RADIUS 31
+
 typedef struct _area
 {
+    /* the bounding box; points are given relative to its origin */
     gint16 start_x;
     gint16 start_y;
     gint16 size_x;
     gint16 size_y;
-    int **area;
+    /* one bit per map position; bit x % 64 of word x / 64 */
+    guint64 rows[MAP_MAX_Y][AREA_WORDS];
 } area;
 
 #define X(pos) ((pos).bf.x)
@@ -103,28 +115,41 @@ rectangle rect_new(int x1, int y1, int x2, int y2);
 rectangle rect_new_sized(position center, int size);
 int pos_in_rect(position pos, rectangle rect);
 
-area *area_new(int start_x, int start_y, int size_x, int size_y);
+/**
+ * Initialise an empty area. Points outside the map can not be set.
+ *
+ * @param the area
+ * @param x of the area's origin
+ * @param y of the area's origin
+ * @param width
+ * @param height
+ */
+void area_init(area *a, int start_x, int start_y, int size_x, int size_y);
 
 /**
  * Draw a circle: Midpoint circle algorithm
  * from http://en.wikipedia.org/wiki/Midpoint_circle_algorithm
  *
+ * The circles are calculated once for every radius up to AREA_MAX_RADIUS.
+ *
+ * @param the area to initialise
  * @param center point of the circle
  * @param radius of the circle
  * @param TRUE if the circle shall not be filled
- * @return a new area.
  */
-area *area_new_circle(position center, guint radius, gboolean hollow);
+void area_init_circle(area *a, position center, guint radius, gboolean hollow);
 
 /**
  * Draw a circle with every unobstucted point inside it set.
  *
+ * @param the area to initialise
  * @param center point of the circle
  * @param radius of the circle
- * @param An area with every obstructed point set.
- * @return a new area.
+ * @param An area with every obstructed point set, as returned by
+ *        map_get_obstacles() for the same center and radius.
  */
-area *area_new_circle_flooded(position center, guint radius, area *obstacles);
+void area_init_circle_flooded(area *a, position center, guint radius,
+                              const area *obstacles);
 
 /* callback function for blasts */
 typedef gboolean (*area_hit_sth)(position pos, const damage_originator *damo,
@@ -150,36 +175,28 @@ gboolean area_blast(position center, guint radius,
                     gpointer data1, gpointer data2,
                     char glyph, int colour);
 
-/**
- * @brief Destroy a given area
- *
- * @param An area.
- */
-void area_destroy(area *a);
-
 /**
  * Add one area to another.
  *
- * @param first area (will be returned)
- * @param second area (will be freed)
- * @return first area with additional set point of second area
+ * @param first area
+ * @param second area of the same dimensions
  */
-area *area_add(area *a, area *b);
+void area_add(area *a, const area *b);
 
 /**
  * Flood fill an area from a given starting point
  *
- * @param an area which marks the points which shall not be flooded (will be freed)
+ * @param the area to initialise with all reached points set
+ * @param an area which marks the points which shall not be flooded
  * @param starting x
  * @param starting y
- * @return an area with all reached points set (newly allocated, must be freed)
  */
-area *area_flood(area *obstacles, int start_x, int start_y);
+void area_flood(area *flood, const area *obstacles, int start_x, int start_y);
 
 void area_point_set(area *a, int x, int y);
-int  area_point_get(area *a, int x, int y);
-int area_point_valid(area *a, int x, int y);
+int  area_point_get(const area *a, int x, int y);
+int area_point_valid(const area *a, int x, int y);
 
-int  area_pos_get(area *a, position pos);
+int  area_pos_get(const area *a, position pos);
 
 #endif
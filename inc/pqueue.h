@@ -0,0 +1,79 @@
+/*
+ * pqueue.h
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PQUEUE_H_
+#define __PQUEUE_H_
+
+#include <glib.h>
+
+/* the members of this struct are only known to the implementation of the
+   following functions */
+struct _pqueue;
+typedef struct _pqueue pqueue;
+
+/**
+ * @brief Create a new priority queue.
+ *
+ * Elements with the lowest key are returned first. Elements with
+ * identical keys are returned in the order they have been added.
+ *
+ * @return A new, empty priority queue.
+ */
+pqueue *pqueue_new();
+
+/**
+ * @brief Free a priority queue.
+ *
+ * @param A priority queue.
+ */
+void pqueue_destroy(pqueue *q);
+
+/**
+ * @brief Add an element to a priority queue.
+ *
+ * @param A priority queue.
+ * @param The key of the element.
+ * @param The element.
+ */
+void pqueue_push(pqueue *q, guint32 key, gpointer data);
+
+/**
+ * @brief Remove the element with the lowest key from a priority queue.
+ *
+ * @param A priority queue.
+ * @param A pointer to store the element's key, may be NULL.
+ * @return The element or NULL if the queue is empty.
+ */
+gpointer pqueue_pop(pqueue *q, guint32 *key);
+
+/**
+ * @brief Remove all elements from a priority queue.
+ *
+ * @param A priority queue.
+ */
+void pqueue_clear(pqueue *q);
+
+/**
+ * @brief Get the number of elements in a priority queue.
+ *
+ * @param A priority queue.
+ * @return The number of elements.
+ */
+guint pqueue_length(pqueue *q);
+
+#endif
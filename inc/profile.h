@@ -0,0 +1,173 @@
+/*
+ * profile.h
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Counts the calls of the game's most expensive functions and the time
+ * spent in them. Measuring costs two clock reads per call, hence it is
+ * always enabled. Each thread keeps its own counters.
+ *
+ * Likewise, the memory used by the game's objects is accounted for
+ * each subsystem.
+ *
+ * Optionally, each measured call is written to a trace file in the
+ * Chrome trace event format, which can be opened with chrome://tracing
+ * or https://ui.perfetto.dev to inspect single turns.
+ */
+
+#ifndef __PROFILE_H_
+#define __PROFILE_H_
+
+#include <glib.h>
+
+#include "cJSON.h"
+
+/* the measured functions; times include the functions called by them */
+typedef enum _profile_phase
+{
+    PP_TURN,            /* game_spin_the_wheel() */
+    PP_MAP_TIMER,       /* map_timer() */
+    PP_MONSTER_ACT,     /* monster_act() */
+    PP_PATH_FIND,       /* path_find() */
+    PP_FOV_CALCULATE,   /* fov_calculate() */
+    PP_PLAYER_FOV,      /* player_update_fov() */
+    PP_PAINT,           /* display_paint_screen() */
+    PP_SAVE,            /* game_save() */
+    PP_INV_ADD,         /* inv_add() */
+    PP_MAX
+} profile_phase;
+
+/* the subsystems whose memory is accounted */
+typedef enum _profile_memory
+{
+    PM_ITEMS,
+    PM_EFFECTS,
+    PM_MONSTERS,
+    PM_MAPS,
+    PM_INVENTORIES,     /* on the map, carried or in containers */
+    PM_MESSAGE_LOG,
+    PM_PLAYER_MEMORY,   /* the player's memory of the maps */
+    PM_SAVE_BUFFERS,    /* the text of the save game while saving or loading */
+    PM_MAX
+} profile_memory;
+
+/**
+ * @brief Start measuring a call.
+ *
+ * @return The current time in nanoseconds, to be passed to profile_end().
+ */
+gint64 profile_begin();
+
+/**
+ * @brief Finish measuring a call.
+ *
+ * @param The measured function.
+ * @param The value returned by profile_begin().
+ */
+void profile_end(profile_phase phase, gint64 start);
+
+/**
+ * @brief Finish measuring a call and describe it in the trace.
+ *
+ * @param The measured function.
+ * @param The value returned by profile_begin().
+ * @param Pairs of names and values describing the call, terminated by NULL.
+ */
+void profile_end_tagged(profile_phase phase, gint64 start, ...);
+
+/**
+ * @brief Add the value of a counter to the trace.
+ *
+ * @param The name of the counter.
+ * @param The current value.
+ */
+void profile_trace_counter(const char *name, gint64 value);
+
+/**
+ * @brief Start writing the trace file, which is completed when the
+ *        process exits.
+ *
+ * @param The name of the file.
+ * @return FALSE if the file could not be opened.
+ */
+gboolean profile_trace_start(const char *filename);
+
+/**
+ * @brief Add the time spent since the previous call to the per-turn
+ *        histograms. Called once per game turn.
+ */
+void profile_turn_end();
+
+/**
+ * @brief Account memory allocated for an object.
+ *
+ * @param The subsystem the object belongs to.
+ * @param The size of the object.
+ */
+void profile_alloc(profile_memory subsystem, gsize size);
+
+/**
+ * @brief Account memory freed for an object.
+ *
+ * @param The subsystem the object belongs to.
+ * @param The size passed to profile_alloc().
+ */
+void profile_free(profile_memory subsystem, gsize size);
+
+/**
+ * @brief Describe the collected data in a human readable form.
+ *
+ * @return A newly allocated string.
+ */
+char *profile_report();
+
+/**
+ * @brief Describe the memory use in a human readable form.
+ *
+ * @return A newly allocated string.
+ */
+char *profile_memory_report();
+
+/**
+ * @brief Serialize the collected data including the histograms.
+ *
+ * @return A JSON object.
+ */
+cJSON *profile_serialize();
+
+/**
+ * @brief Serialize the memory use of all subsystems.
+ *
+ * @return A JSON object.
+ */
+cJSON *profile_memory_serialize();
+
+/**
+ * @brief Write the collected data to a file when the process exits.
+ *
+ * @param The name of the file.
+ */
+void profile_write_on_exit(const char *filename);
+
+/**
+ * @brief Write the memory use to a file when the process exits.
+ *
+ * @param The name of the file.
+ */
+void profile_memory_write_on_exit(const char *filename);
+
+#endif
@@ -23,12 +23,48 @@
 
 #include "cJSON.h"
 
+/* the state of a random number generator */
+typedef struct _rng_state
+{
+    guint32 s[4];
+    gboolean seeded;
+} rng_state;
+
+/* a sampler drawing indices with given weights (Walker's alias method) */
+typedef struct _rand_alias
+{
+    guint count;
+    guint32 total;          /* the sum of the weights */
+    struct
+    {
+        guint32 prob;       /* keep the index if a draw below total is below this */
+        guint32 alias;      /* the index chosen otherwise */
+    } entries[];
+} rand_alias;
+
 /* function definitions */
 
+/**
+ * @brief Select the random number generator used by the calling thread.
+ *
+ * @param The state of the generator. NULL selects the thread's own
+ *        generator, which is used until another one has been selected.
+ */
+void rand_use_state(rng_state *state);
+
+/**
+ * @brief Seed the selected random number generator.
+ *
+ * Generators seeded with the same value produce the same sequence.
+ *
+ * @param The seed
+ */
+void rand_set_seed(guint32 seed);
+
 cJSON* rand_serialize();
 void rand_deserialize(cJSON *r);
 
-/* The following function use a global state
+/* The following function use the selected state
  * which is automatically seeded on first usage. */
 
 guint32 rand_0n(guint32 n);
@@ -52,6 +88,25 @@ static inline gboolean chance(guint32 percent)
 
 int divert(int value, int percent);
 
+/**
+ * @brief Prepare drawing indices with the given weights.
+ *
+ * @param The weights. The sum must be less than G_MAXUINT32.
+ * @param The number of weights.
+ * @return A new sampler or NULL if all weights are zero.
+ */
+rand_alias *rand_alias_new(const guint32 weights[], guint count);
+
+/**
+ * @brief Draw an index. Takes one or two random numbers.
+ *
+ * @param The sampler.
+ * @return An index whose weight is not zero.
+ */
+guint rand_alias_draw(rand_alias *ra);
+
+void rand_alias_destroy(rand_alias *ra);
+
 /**
  * Shuffle an array of integers
  *
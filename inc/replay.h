@@ -0,0 +1,90 @@
+/*
+ * replay.h
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A recording consists of the seed of the random number generator, the
+ * game settings and every key pressed by the player. As the game is
+ * deterministic, playing back the keys reproduces the entire game.
+ */
+
+#ifndef __REPLAY_H_
+#define __REPLAY_H_
+
+#include <glib.h>
+
+struct game_config;
+
+/**
+ * @brief Start recording a new game.
+ *
+ * @param The name of the file to write.
+ * @param The game settings, which are stored with the recording.
+ * @return TRUE on success.
+ */
+gboolean replay_record_start(const char *filename, struct game_config *config);
+
+/**
+ * @brief Start playing back a recording.
+ *
+ * @param The name of the file to read.
+ * @param The game settings, which are replaced by the recorded ones.
+ * @param Play back at maximum speed without painting the screen
+ *        until the game has reached this turn.
+ * @return TRUE on success.
+ */
+gboolean replay_play_start(const char *filename, struct game_config *config,
+                           guint32 turn);
+
+/**
+ * @brief Finish recording or playing back, e.g. when the game has ended.
+ */
+void replay_stop();
+
+/**
+ * @brief Check if a game is being recorded or played back.
+ *
+ * @return TRUE if the game has to be started with replay_seed().
+ */
+gboolean replay_active();
+
+/**
+ * @brief Get the seed of the recorded game's random number generator.
+ *
+ * @return The seed.
+ */
+guint32 replay_seed();
+
+/**
+ * @brief Get the next key of the recording that is played back.
+ *
+ * The display is suspended while fast-forwarding to the requested turn.
+ * When the recording is exhausted, the player takes over.
+ *
+ * @param A pointer to store the key.
+ * @return FALSE if no recording is played back.
+ */
+gboolean replay_key_get(int *key);
+
+/**
+ * @brief Add a key pressed by the player to the recording.
+ *
+ * @param The key.
+ */
+void replay_key_add(int key);
+
+#endif
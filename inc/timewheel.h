@@ -0,0 +1,86 @@
+/*
+ * timewheel.h
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TIMEWHEEL_H_
+#define __TIMEWHEEL_H_
+
+#include <glib.h>
+
+/* the members of this struct are only known to the implementation of the
+   following functions */
+struct _timewheel;
+typedef struct _timewheel timewheel;
+
+/* a scheduled timer */
+typedef struct timewheel_entry
+{
+    guint32 when;       /* game turn the timer is due */
+    guint32 kind;       /* user defined type of the timer */
+    gpointer data1;     /* user data */
+    gpointer data2;     /* user data */
+} timewheel_entry;
+
+/* callback function for due timers */
+typedef void (*timewheel_func)(const timewheel_entry *entry, gpointer data);
+
+/**
+ * @brief Create a new hierarchical timer wheel.
+ *
+ * @param The current game turn. Timers due at this turn or earlier
+ *        will be processed on the next call to timewheel_advance().
+ * @return A new timer wheel.
+ */
+timewheel *timewheel_new(guint32 now);
+
+/**
+ * @brief Free a timer wheel and all pending timers.
+ *
+ * @param A timer wheel.
+ */
+void timewheel_destroy(timewheel *tw);
+
+/**
+ * @brief Schedule a timer.
+ *
+ * Timers can not be cancelled. The callback has to check if the timer
+ * is still of interest when it is due.
+ *
+ * @param A timer wheel.
+ * @param The game turn the timer is due.
+ * @param The user defined type of the timer.
+ * @param User data passed to the callback.
+ * @param User data passed to the callback.
+ */
+void timewheel_add(timewheel *tw, guint32 when, guint32 kind,
+                   gpointer data1, gpointer data2);
+
+/**
+ * @brief Call the callback for every timer due up to a given game turn.
+ *
+ * Only the timers that are actually due are visited. If the game time
+ * has been turned back, the pending timers are redistributed.
+ *
+ * @param A timer wheel.
+ * @param The current game turn.
+ * @param The callback function for due timers.
+ * @param A pointer passed to the callback function.
+ */
+void timewheel_advance(timewheel *tw, guint32 now,
+                       timewheel_func func, gpointer data);
+
+#endif
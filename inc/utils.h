@@ -24,19 +24,56 @@
 #include "cJSON.h"
 
 /* game messaging */
+#define LOG_MAX_LENGTH 100
+
+/*
+ * Messages are not stored as text but packed: the number of the format
+ * string followed by the arguments, i.e. strings including the terminating
+ * zero and numbers as 32 bit integers. The text is assembled only when
+ * the messages are displayed.
+ */
 typedef struct _message_log_entry
 {
     guint32 gtime;      /* game time of log entry */
-    char *message;
+    guint32 size;       /* length of the packed messages */
+    guint8 *data;       /* stored in the log's chunks */
 } message_log_entry;
 
+/* a block of memory holding the messages of consecutive log entries */
+typedef struct _message_log_chunk
+{
+    struct _message_log_chunk *next;
+    gsize size;         /* capacity of data */
+    gsize used;
+    guint entries;      /* number of entries referring to the chunk */
+    guint8 data[];
+} message_log_chunk;
+
 typedef struct _message_log
 {
     guint32 gtime;      /* current game time */
     gint32 active;      /* flag to disable logging onto this log */
-    GString *buffer;    /* space to assemble a turn's messages */
-    char *lastmsg;      /* copy of last message */
-    GPtrArray *entries;
+    GByteArray *pending; /* the packed messages of the current turn */
+    guint lastmsg;      /* offset of the last message in pending */
+    GString *buffer;    /* the text of the pending messages */
+    gboolean buffer_valid;
+    GString *text;      /* the text of an entry, see log_entry_text() */
+
+    /* the format strings of the messages; the first one is "%s" */
+    GPtrArray *templates;
+    GHashTable *template_ids;
+
+    /* the entries are stored in a ring buffer, the oldest at first */
+    message_log_entry entries[LOG_MAX_LENGTH];
+    guint first;
+    guint count;
+
+    /* the text of the entries, the oldest chunk at head. As entries are
+       removed in the order they have been added, a chunk can be reused
+       as soon as all its entries have been removed. */
+    message_log_chunk *head;
+    message_log_chunk *tail;
+    message_log_chunk *spare;
 } message_log;
 
 /* windef.h defines these */
@@ -45,6 +82,13 @@ typedef struct _message_log
 #undef max
 #endif
 
+/* variables of which each thread has its own copy */
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 static inline int min(int x, int y) { return x > y ? y : x; }
 static inline int max(int x, int y) { return x > y ? x : y; }
 
@@ -66,18 +110,31 @@ int log_add_entry(message_log *log, const char *fmt, ...);
 void log_set_time(message_log *log, int gtime);
 
 message_log_entry *log_get_entry(message_log *log, guint id);
+
+/**
+ * @brief Assemble the text of a log entry.
+ *
+ * @param the log
+ * @param an entry returned by log_get_entry()
+ * @return the text, valid until the function is called again
+ */
+const char *log_entry_text(message_log *log, message_log_entry *entry);
+
+/**
+ * @brief Assemble the text of the current turn's messages.
+ *
+ * @param the log
+ * @return the text or NULL if there are no messages
+ */
+const char *log_buffer(message_log *log);
+
 cJSON *log_serialize(message_log *log);
 message_log *log_deserialize(cJSON *lser);
 
-static inline guint log_length(message_log *log) { return log->entries->len; }
+static inline guint log_length(message_log *log) { return log->count; }
 static inline void log_enable(message_log *log)  { log->active = TRUE; }
 static inline void log_disable(message_log *log) { log->active = FALSE; }
 
-static inline char *log_buffer(message_log *log)
-{
-    return log->buffer->len ? log->buffer->str : NULL;
-}
-
 /* text array handling */
 GPtrArray *text_wrap(const char *str, int width, int indent);
 
@@ -0,0 +1,233 @@
+/*
+ * agent.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "agent.h"
+#include "config.h"
+#include "extdefs.h"
+#include "fov.h"
+#include "game.h"
+#include "items.h"
+#include "sobjects.h"
+
+/* the state of the agent playing on the calling thread */
+typedef struct _agent_state
+{
+    game *g;                    /* the game, NULL when it has ended */
+    guint32 log_time;           /* game time of the first unreported message */
+    agent_observation obs;      /* the latest observation */
+} agent_state;
+
+static THREAD_LOCAL agent_state agent;
+
+/* the directions of the movement actions */
+static const direction agent_directions[] =
+{
+    GD_SW, GD_SOUTH, GD_SE, GD_WEST, GD_EAST, GD_NW, GD_NORTH, GD_NE
+};
+
+static void agent_observe(agent_state *a);
+static char agent_memory_glyph(player *p, map *m, position pos);
+
+const agent_observation *nlarn_reset(guint32 seed)
+{
+    /* the config's strings are modified by game_create() */
+    char name[] = "Agent";
+    char gender[] = "m";
+    char stats[] = "a";
+    struct game_config config = { 0 };
+
+    config.name = name;
+    config.gender = gender;
+    config.stats = stats;
+    config.no_autosave = TRUE;
+
+    nlarn_close();
+
+    agent.g = game_create(&config, seed);
+    agent.log_time = 0;
+    agent.obs.monsters = g_array_new(FALSE, FALSE, sizeof(agent_monster));
+    agent.obs.messages = g_ptr_array_new_with_free_func(g_free);
+
+    player_update_fov(agent.g->p);
+    agent_observe(&agent);
+
+    return &agent.obs;
+}
+
+const agent_observation *nlarn_step(agent_action action)
+{
+    int moves_count = 0;
+    player *p;
+
+    g_assert(action < AA_MAX);
+
+    /* nothing happens after the end */
+    if (agent.g == NULL)
+        return &agent.obs;
+
+    /* the thread might have worked on another game in the meantime */
+    game_set_current(agent.g);
+    p = agent.g->p;
+
+    /* player_die() destroys the game and returns here */
+    player_cod cod = setjmp(nlarn_death_jump);
+
+    if (cod != PD_NONE)
+    {
+        agent.g = NULL;
+        agent.obs.done = TRUE;
+        agent.obs.cause = cod;
+        g_array_set_size(agent.obs.monsters, 0);
+        g_ptr_array_set_size(agent.obs.messages, 0);
+
+        return &agent.obs;
+    }
+
+    switch (action)
+    {
+    case AA_WAIT:
+        moves_count = 1;
+        break;
+
+    case AA_PICKUP:
+        player_pickup(p);
+        break;
+
+    case AA_STAIRS_DOWN:
+        moves_count = player_stairs_down(p);
+        break;
+
+    case AA_STAIRS_UP:
+        moves_count = player_stairs_up(p);
+        break;
+
+    default:
+        moves_count = player_move(p, agent_directions[action - AA_MOVE_SW], TRUE);
+        break;
+    }
+
+    /* manipulate game time */
+    if (moves_count)
+    {
+        player_make_move(p, moves_count, FALSE, NULL);
+        p->attacked = FALSE;
+    }
+
+    /* recalculate FOV */
+    player_update_fov(p);
+
+    agent_observe(&agent);
+
+    return &agent.obs;
+}
+
+gboolean nlarn_done()
+{
+    return (agent.g == NULL);
+}
+
+void nlarn_close()
+{
+    if (agent.g != NULL)
+        agent.g = game_destroy(agent.g);
+
+    if (agent.obs.monsters != NULL)
+        g_array_free(agent.obs.monsters, TRUE);
+
+    if (agent.obs.messages != NULL)
+        g_ptr_array_free(agent.obs.messages, TRUE);
+
+    memset(&agent.obs, 0, sizeof(agent_observation));
+}
+
+static void agent_observe(agent_state *a)
+{
+    player *p = a->g->p;
+    map *m = game_map(a->g, Z(p->pos));
+    message_log *log = a->g->log;
+    position pos = pos_invalid;
+    GList *mlist, *iter;
+
+    /* the map as remembered by the player */
+    Z(pos) = Z(p->pos);
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+            a->obs.map[Y(pos)][X(pos)] = agent_memory_glyph(p, m, pos);
+
+    a->obs.pos = p->pos;
+    a->obs.turn = game_turn(a->g);
+    a->obs.hp = p->hp;
+    a->obs.hp_max = p->hp_max;
+    a->obs.mp = p->mp;
+    a->obs.mp_max = p->mp_max;
+    a->obs.level = p->level;
+    a->obs.experience = p->experience;
+    a->obs.gold = player_get_gold(p);
+
+    /* the visible monsters */
+    g_array_set_size(a->obs.monsters, 0);
+    mlist = fov_get_visible_monsters(p->fv);
+
+    for (iter = mlist; iter != NULL; iter = iter->next)
+    {
+        agent_monster am = { monster_type(iter->data), monster_pos(iter->data) };
+        g_array_append_val(a->obs.monsters, am);
+    }
+
+    g_list_free(mlist);
+
+    /* the messages that have been added to the log since the last call */
+    guint first = log_length(log);
+
+    while (first > 0 && log_get_entry(log, first - 1)->gtime >= a->log_time)
+        first--;
+
+    g_ptr_array_set_size(a->obs.messages, 0);
+
+    for (guint idx = first; idx < log_length(log); idx++)
+        g_ptr_array_add(a->obs.messages,
+                        g_strdup(log_entry_text(log, log_get_entry(log, idx))));
+
+    /* messages still pending are stamped with the current time */
+    a->log_time = log->gtime;
+}
+
+static char agent_memory_glyph(player *p, map *m, position pos)
+{
+    const player_tile_memory *mem = &player_memory_of(p, pos);
+
+    if (mem->sobject)
+    {
+        if (mem->sobject == LS_CLOSEDDOOR || mem->sobject == LS_OPENDOOR)
+            return map_get_door_glyph(m, pos);
+
+        return so_get_glyph(mem->sobject);
+    }
+
+    if (mem->item)
+        return item_glyph(mem->item);
+
+    if (mem->trap)
+        return '^';
+
+    return mt_get_glyph(mem->type);
+}
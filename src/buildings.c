@@ -641,7 +641,12 @@ static int building_scribe_scroll(player *p)
         split = TRUE;
     }
 
-    bscroll->id = i;
+    /* a split scroll is not part of the inventory yet */
+    if (split)
+        bscroll->id = i;
+    else
+        inv_item_rekey(p->inventory, bscroll, i);
+
     p->identified_scrolls[i] = TRUE;
 
     building_player_charge(p, price);
@@ -1168,7 +1173,7 @@ int building_monastery(struct player *p)
                 int choice;
                 char *question;
                 effect *e = player_effect_get(p, curable_diseases[selection].et);
-                int price = e->turns * (game_difficulty(nlarn) + 1);
+                int price = effect_turns_left(e) * (game_difficulty(nlarn) + 1);
 
                 question = g_strdup_printf("For healing you from %s, we ask that you "
                                            "donate %d gold for our monastery. %s",
@@ -1546,6 +1551,7 @@ static void building_item_repair(player *p, inventory **inv __attribute__((unuse
             it->burnt = 0;
             it->corroded = 0;
             it->rusty = 0;
+            player_modifiers_invalidate(p);
 
             name[0] = g_ascii_toupper(name[0]);
             log_add_entry(nlarn->log, "%s has been repaired.", name);
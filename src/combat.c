@@ -20,6 +20,7 @@
 
 #include "combat.h"
 #include "enumFactory.h"
+#include "utils.h"
 
 DEFINE_ENUM(speed, SPEED_ENUM)
 DEFINE_ENUM(size, SIZE_ENUM)
@@ -27,33 +28,9 @@ DEFINE_ENUM(attack_t, ATTACK_T_ENUM)
 DEFINE_ENUM(damage_t, DAMAGE_T_ENUM)
 DEFINE_ENUM(damage_originator_t, DAMAGE_ORIGINATOR_T_ENUM)
 
-damage *damage_new(damage_t type, attack_t att_type, int amount,
-                   damage_originator_t damo, gpointer originator)
+char *damage_to_str(const damage *dam)
 {
-    damage *dam = g_malloc0(sizeof(damage));
-
-    dam->type = type;
-    dam->attack = att_type;
-    dam->amount = amount;
-    dam->dam_origin.ot = damo;
-    dam->dam_origin.originator = originator;
-
-    return dam;
-}
-
-damage *damage_copy(damage *dam)
-{
-    g_assert (dam != NULL);
-
-    damage *dcopy = g_malloc(sizeof(damage));
-    memcpy(dcopy, dam, sizeof(damage));
-
-    return dcopy;
-}
-
-char *damage_to_str(damage *dam)
-{
-    static char buf[121];
+    static THREAD_LOCAL char buf[121];
     g_snprintf(buf, 120, "[%s - %s - %s: %d]",
             attack_t_string(dam->attack),
             damage_t_string(dam->type),
@@ -76,6 +76,11 @@ void free_config(const struct game_config config)
     if (config.gender)      g_free(config.gender);
     if (config.stats)       g_free(config.stats);
     if (config.auto_pickup) g_free(config.auto_pickup);
+    if (config.record)      g_free(config.record);
+    if (config.replay)      g_free(config.replay);
+    if (config.profile_out) g_free(config.profile_out);
+    if (config.trace)       g_free(config.trace);
+    if (config.mem_report)  g_free(config.mem_report);
 }
 
 /* parse the command line */
@@ -89,6 +94,13 @@ void parse_commandline(int argc, char *argv[], struct game_config *config)
         { "auto-pickup", 'a', 0, G_OPTION_ARG_STRING, &config->auto_pickup,  "Item types to pick up automatically, e.g. '$*+'", NULL },
         { "no-autosave", 'N', 0, G_OPTION_ARG_NONE,   &config->no_autosave,  "Disable autosave", NULL },
         { "wizard",      'w', 0, G_OPTION_ARG_NONE,   &config->wizard,       "Enable wizard mode", NULL },
+        { "headless",    'H', 0, G_OPTION_ARG_NONE,   &config->headless,     "Show nothing and read keys from stdin, e.g. for bots", NULL },
+        { "record",      'r', 0, G_OPTION_ARG_FILENAME, &config->record,     "Record a new game to a file", NULL },
+        { "replay",      'R', 0, G_OPTION_ARG_FILENAME, &config->replay,     "Play back a recorded game", NULL },
+        { "replay-turn", 't', 0, G_OPTION_ARG_INT,    &config->replay_turn,  "Play back at maximum speed until this turn", NULL },
+        { "profile-out", 'p', 0, G_OPTION_ARG_FILENAME, &config->profile_out, "Write the time spent in the game's functions to a file on exit", NULL },
+        { "trace",       'T', 0, G_OPTION_ARG_FILENAME, &config->trace,      "Write a trace of the game's functions in Chrome's trace event format", NULL },
+        { "mem-report",  'M', 0, G_OPTION_ARG_FILENAME, &config->mem_report, "Write the memory used by the game's subsystems to a file on exit", NULL },
 #ifdef SDLPDCURSES
         { "font-size",   'S', 0, G_OPTION_ARG_INT,    &config->font_size,   "Set font size", NULL },
 #endif
@@ -24,6 +24,8 @@
 #include "display.h"
 #include "fov.h"
 #include "map.h"
+#include "profile.h"
+#include "replay.h"
 #include "extdefs.h"
 #include "spheres.h"
 
@@ -80,8 +82,27 @@ const display_colset display_dialog_colset[] =
     { NULL,           0}
 };
 
+/* the display is shared by the entire process, see game.h */
 static gboolean display_initialised = FALSE;
 
+/* the backend chosen in display_init() */
+static display_backend display_output = DB_CURSES;
+
+/* painting has been stopped by display_suspend() */
+static gboolean display_suspended = FALSE;
+
+/* painting is pointless without a terminal to paint on */
+#define display_visible() (display_initialised && display_output != DB_NULL \
+                           && !display_suspended)
+
+/* there is someone watching the screen and typing */
+#define display_interactive() (display_visible() && display_output == DB_CURSES)
+
+/* the map cells as they have been painted by display_paint_screen(); used
+   to reduce the output to the terminal, not the work of computing them */
+static chtype display_map_frame[MAP_MAX_Y][MAP_MAX_X];
+static gboolean display_map_valid = FALSE;
+
 /* linked list of opened windows */
 static GList *windows = NULL;
 
@@ -104,10 +125,10 @@ static void display_window_update_arrow_down(display_window *dwin, gboolean on);
 static display_window *display_item_details(guint x1, guint y1, guint width,
                                             item *it, player *p, gboolean shop);
 
-static void display_spheres_paint(sphere *s, player *p);
-
-void display_init()
+void display_init(display_backend backend)
 {
+    display_output = backend;
+
 #ifdef NCURSES_VERSION
     /*
      * Don't wait for trailing key codes after an ESC key is pressed.
@@ -133,8 +154,28 @@ void display_init()
     g_free(font_name);
 #endif
 
-    /* Start curses mode */
-    initscr();
+    if (backend != DB_CURSES)
+    {
+#ifdef NCURSES_VERSION
+        /* Start curses mode without a terminal: all output is
+           discarded and the keys are read from stdin. */
+        FILE *out = fopen("/dev/null", "w");
+
+        if (out == NULL || newterm("vt100", out, stdin) == NULL)
+        {
+            g_printerr("Failed to initialise the headless display.\n");
+            exit(EXIT_FAILURE);
+        }
+#else
+        g_printerr("The headless displays require ncurses.\n");
+        exit(EXIT_FAILURE);
+#endif
+    }
+    else
+    {
+        /* Start curses mode */
+        initscr();
+    }
 
 #ifdef SDLPDCURSES
     /* These initialisations have to be done after initscr(), otherwise
@@ -191,6 +232,25 @@ void display_init()
 
     /* update display initialisation status */
     display_initialised = TRUE;
+    display_map_valid = FALSE;
+}
+
+guint display_colour_index(int colour)
+{
+    for (guint idx = 0; display_default_colset[idx].name != NULL; idx++)
+    {
+        if (display_default_colset[idx].val == colour)
+            return idx;
+    }
+
+    return 0;
+}
+
+int display_colour_at(guint index)
+{
+    g_assert(index < G_N_ELEMENTS(display_default_colset) - 1);
+
+    return display_default_colset[index].val;
 }
 
 static int attr_colour(int colour, int reverse)
@@ -237,11 +297,21 @@ static int attr_colour(int colour, int reverse)
     mvwhline(win, y, x, ch, n); \
     wattroff(win, attrs)
 
+/* combine attributes and a glyph to the content of a screen cell */
+#define display_cell(attrs, ch) ((chtype)(attrs) | (unsigned char)(ch))
+
 void display_paint_screen(player *p)
 {
     position pos = pos_invalid;
     map *vmap;
     int attrs;              /* curses attributes */
+    chtype frame[MAP_MAX_Y][MAP_MAX_X]; /* the map cells to be painted */
+
+    /* nobody is watching */
+    if (!display_visible())
+        return;
+
+    gint64 prof_start = profile_begin();
 
     /* draw line around map */
     (void)mvhline(MAP_MAX_Y, 0, ACS_HLINE, MAP_MAX_X);
@@ -251,15 +321,16 @@ void display_paint_screen(player *p)
     /* make shortcut to the visible map */
     vmap = game_map(nlarn, Z(p->pos));
 
-    /* draw map */
+    /* Determine the content of all map cells. Every cell is computed anew
+       for each frame; only writing them to the screen is restricted to the
+       cells that have changed, see below. */
     Z(pos) = Z(p->pos);
     for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
     {
-        /* position cursor */
-        move(Y(pos), 0);
-
         for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
         {
+            chtype *cell = &frame[Y(pos)][X(pos)];
+
             if (game_fullvis(nlarn) || fov_get(p->fv, pos))
             {
                 /* draw the truth */
@@ -275,8 +346,8 @@ void display_paint_screen(player *p)
                     else
                         glyph = so_get_glyph(map_sobject_at(vmap, pos));
 
-                    aaddch(attr_colour(so_get_colour(map_sobject_at(vmap, pos)), has_items),
-                           glyph);
+                    *cell = display_cell(attr_colour(so_get_colour(map_sobject_at(vmap, pos)), has_items),
+                                         glyph);
                 }
                 else if (has_items)
                 {
@@ -284,15 +355,15 @@ void display_paint_screen(player *p)
                     item *it;
 
                     /* memorize the most interesting item on the tile */
-                    if (inv_length_filtered(*inv, item_filter_gems) > 0)
+                    if (inv_length_type(*inv, IT_GEM) > 0)
                     {
                         /* there's a gem in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gems);
+                        it = inv_get_type(*inv, 0, IT_GEM);
                     }
-                    else if (inv_length_filtered(*inv, item_filter_gold) > 0)
+                    else if (inv_length_type(*inv, IT_GOLD) > 0)
                     {
                         /* there is gold in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gold);
+                        it = inv_get_type(*inv, 0, IT_GOLD);
                     }
                     else
                     {
@@ -303,19 +374,19 @@ void display_paint_screen(player *p)
                     const gboolean has_trap = (map_trap_at(vmap, pos)
                                                && player_memory_of(p, pos).trap);
 
-                    aaddch(attr_colour(item_colour(it), has_trap),
-                           item_glyph(it->type));
+                    *cell = display_cell(attr_colour(item_colour(it), has_trap),
+                                         item_glyph(it->type));
                 }
                 else if (map_trap_at(vmap, pos) && (game_fullvis(nlarn) || player_memory_of(p, pos).trap))
                 {
                     /* FIXME - displays trap when unknown!! */
-                    aaddch(trap_colour(map_trap_at(vmap, pos)), '^');
+                    *cell = display_cell(trap_colour(map_trap_at(vmap, pos)), '^');
                 }
                 else
                 {
                     /* draw tile */
-                    aaddch(mt_get_colour(map_tiletype_at(vmap, pos)),
-                           mt_get_glyph(map_tiletype_at(vmap, pos)));
+                    *cell = display_cell(mt_get_colour(map_tiletype_at(vmap, pos)),
+                                         mt_get_glyph(map_tiletype_at(vmap, pos)));
                 }
             }
             else /* i.e. !fullvis && !visible: draw players memory */
@@ -332,25 +403,26 @@ void display_paint_screen(player *p)
                     else
                         glyph = so_get_glyph(ms);
 
-                    aaddch(attr_colour(so_get_colour(ms), has_items), glyph);
+                    *cell = display_cell(attr_colour(so_get_colour(ms), has_items), glyph);
                 }
                 else if (has_items)
                 {
                     /* draw items */
                     const gboolean has_trap = (player_memory_of(p, pos).trap);
+                    const int colour = display_colour_at(player_memory_of(p, pos).item_colour);
 
-                    aaddch(attr_colour(player_memory_of(p, pos).item_colour, has_trap),
-                           item_glyph(player_memory_of(p, pos).item));
+                    *cell = display_cell(attr_colour(colour, has_trap),
+                                         item_glyph(player_memory_of(p, pos).item));
                 }
                 else if (player_memory_of(p, pos).trap)
                 {
                     /* draw trap */
-                    aaddch(trap_colour(map_trap_at(vmap, pos)), '^');
+                    *cell = display_cell(trap_colour(map_trap_at(vmap, pos)), '^');
                 }
                 else
                 {
                     /* draw tile */
-                    aaddch(DARKGRAY, mt_get_glyph(player_memory_of(p, pos).type));
+                    *cell = display_cell(DARKGRAY, mt_get_glyph(player_memory_of(p, pos).type));
                 }
             }
 
@@ -367,14 +439,23 @@ void display_paint_screen(player *p)
                     || player_effect(p, ET_DETECT_MONSTER)
                     || monster_in_sight(monst))
             {
-                position mpos = monster_pos(monst);
-                mvaaddch(Y(mpos), X(mpos), monster_color(monst), monster_glyph(monst));
+                *cell = display_cell(monster_color(monst), monster_glyph(monst));
             }
         }
     }
 
     /* draw spheres */
-    g_ptr_array_foreach(nlarn->spheres, (GFunc)display_spheres_paint, p);
+    for (guint idx = 0; idx < nlarn->spheres->len; idx++)
+    {
+        sphere *s = g_ptr_array_index(nlarn->spheres, idx);
+
+        /* check if sphere is on current level */
+        if (Z(s->pos) != Z(p->pos))
+            continue;
+
+        if (game_fullvis(nlarn) || fov_get(p->fv, s->pos))
+            frame[Y(s->pos)][X(s->pos)] = display_cell(MAGENTA, '0');
+    }
 
     /* draw player */
     char pc;
@@ -389,7 +470,22 @@ void display_paint_screen(player *p)
         attrs = WHITE;
     }
 
-    mvaaddch(Y(p->pos), X(p->pos), attrs, pc);
+    frame[Y(p->pos)][X(p->pos)] = display_cell(attrs, pc);
+
+    /* only write the cells to the screen that have changed */
+    for (int y = 0; y < MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x < MAP_MAX_X; x++)
+        {
+            if (display_map_valid && frame[y][x] == display_map_frame[y][x])
+                continue;
+
+            (void)mvaddch(y, x, frame[y][x]);
+            display_map_frame[y][x] = frame[y][x];
+        }
+    }
+
+    display_map_valid = TRUE;
 
 
     /* *** first status line below map *** */
@@ -589,7 +685,7 @@ void display_paint_screen(player *p)
             }
 
             if ((e->type == ET_WALL_WALK || e->type == ET_LEVITATION)
-                    && e->turns < 6)
+                    && effect_turns_left(e) < 6)
             {
                 /* fading effects */
                 gchar *cdesc = g_strdup_printf("`lightred`%s`end`", desc);
@@ -655,9 +751,9 @@ void display_paint_screen(player *p)
                                               log_length(nlarn->log) - 1 - i);
 
         if (text == NULL)
-            text = text_wrap(le->message, COLS, 2);
+            text = text_wrap(log_entry_text(nlarn->log, le), COLS, 2);
         else
-            text = text_append(text, text_wrap(le->message, COLS, 2));
+            text = text_append(text, text_wrap(log_entry_text(nlarn->log, le), COLS, 2));
 
         /* store game time for associated text line */
         while ((x <= text->len) && (x <= y))
@@ -689,6 +785,8 @@ void display_paint_screen(player *p)
     text_destroy(text);
 
     display_draw();
+
+    profile_end(PP_PAINT, prof_start);
 }
 
 void display_shutdown()
@@ -711,6 +809,10 @@ gboolean display_available()
 
 void display_draw()
 {
+    /* nothing to show */
+    if (!display_visible())
+        return;
+
 #ifdef PDCURSES
     /* I have no idea why, but panels are not redrawn when
      * using PDCurses without calling touchwin for it. */
@@ -729,14 +831,103 @@ void display_draw()
     doupdate();
 }
 
-static int item_sort_normal(gconstpointer a, gconstpointer b, gpointer data)
+void display_map_invalidate()
 {
-    return item_sort(a, b, data, FALSE);
+    display_map_valid = FALSE;
 }
 
-static int item_sort_shop(gconstpointer a, gconstpointer b, gpointer data)
+void display_paint_glyph(position pos, char glyph, int attrs)
 {
-    return item_sort(a, b, data, TRUE);
+    if (!display_visible())
+        return;
+
+    attron(attrs);
+    (void)mvaddch(Y(pos), X(pos), glyph);
+    attroff(attrs);
+
+    display_map_invalidate();
+}
+
+void display_paint_blast(map *m, const area *blast, char glyph, int attrs)
+{
+    position cursor = pos_invalid;
+
+    if (!display_visible())
+        return;
+
+    Z(cursor) = m->nlevel;
+    attron(attrs);
+
+    for (Y(cursor) = blast->start_y; Y(cursor) < blast->start_y + blast->size_y; Y(cursor)++)
+    {
+        for (X(cursor) = blast->start_x; X(cursor) < blast->start_x + blast->size_x; X(cursor)++)
+        {
+            monster *mon;
+
+            /* skip this position if it is not affected by the blast */
+            if (!area_pos_get(blast, cursor))
+                continue;
+
+            if (map_sobject_at(m, cursor))
+            {
+                /* The blast hit a stationary object. */
+                (void)mvaddch(Y(cursor), X(cursor),
+                              so_get_glyph(map_sobject_at(m, cursor)));
+            }
+            else if ((mon = map_get_monster_at(m, cursor)) && monster_in_sight(mon))
+            {
+                /* The blast hit a visible monster */
+                (void)mvaddch(Y(cursor), X(cursor), monster_glyph(mon));
+            }
+            else if (pos_identical(nlarn->p->pos, cursor))
+            {
+                /* The blast hit the player */
+                (void)mvaddch(Y(cursor), X(cursor), '@');
+            }
+            else
+            {
+                /* The blast hit nothing */
+                (void)mvaddch(Y(cursor), X(cursor), glyph);
+            }
+        }
+    }
+
+    attroff(attrs);
+    display_map_invalidate();
+}
+
+void display_delay(int ms)
+{
+    /* bots and scripts don't need time to look */
+    if (!display_interactive())
+        return;
+
+    napms(ms);
+}
+
+void display_suspend(gboolean suspend)
+{
+    display_suspended = suspend;
+
+    if (!suspend && display_visible())
+    {
+        /* the screen is outdated */
+        display_map_invalidate();
+
+        if (nlarn)
+            display_paint_screen(nlarn->p);
+
+        display_draw();
+    }
+}
+
+void display_flush_input()
+{
+    /* scripted input must not be lost */
+    if (!display_interactive())
+        return;
+
+    flushinp();
 }
 
 item *display_inventory(const char *title, player *p, inventory **inv,
@@ -744,6 +935,10 @@ item *display_inventory(const char *title, player *p, inventory **inv,
                         gboolean show_weight, gboolean show_account,
                         int (*ifilter)(item *))
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return NULL;
+
     /* the inventory window */
     display_window *iwin = NULL;
     /* the item description pop-up */
@@ -779,10 +974,7 @@ item *display_inventory(const char *title, player *p, inventory **inv,
     g_assert(p != NULL && inv != NULL);
 
     /* sort inventory by item type */
-    if (show_price)
-        inv_sort(*inv, (GCompareDataFunc)item_sort_shop, (gpointer)p);
-    else
-        inv_sort(*inv, (GCompareDataFunc)item_sort_normal, (gpointer)p);
+    item_sort(*inv, p, show_price);
 
     /* store inventory length */
     len_orig = len_curr = inv_length_filtered(*inv, ifilter);
@@ -823,10 +1015,7 @@ item *display_inventory(const char *title, player *p, inventory **inv,
             else if (len_curr > len_orig)
             {
                 /* inventory has grown - sort inventory again */
-                if (show_price)
-                    inv_sort(*inv, (GCompareDataFunc)item_sort_shop, (gpointer)p);
-                else
-                    inv_sort(*inv, (GCompareDataFunc)item_sort_normal, (gpointer)p);
+                item_sort(*inv, p, show_price);
             }
         }
 
@@ -1200,6 +1389,10 @@ void display_config_autopickup(gboolean settings[IT_MAX])
 
 spell *display_spell_select(const char *title, player *p)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return NULL;
+
     display_window *swin, *ipop = NULL;
     guint width, height;
     guint startx, starty;
@@ -1494,6 +1687,10 @@ mnemonics:
 
 int display_get_count(const char *caption, int value)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return 0;
+
     display_window *mwin;
     int height, width, basewidth;
     int startx, starty;
@@ -1695,6 +1892,10 @@ int display_get_count(const char *caption, int value)
 
 char *display_get_string(const char *title, const char *caption, const char *value, size_t max_len)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return NULL;
+
     /* user input */
     int key;
 
@@ -1892,6 +2093,10 @@ char *display_get_string(const char *title, const char *caption, const char *val
 
 int display_get_yesno(const char *question, const char *title, const char *yes, const char *no)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return FALSE;
+
     display_window *ywin;
     int RUN = TRUE;
     int selection = FALSE;
@@ -2044,6 +2249,10 @@ int display_get_yesno(const char *question, const char *title, const char *yes,
 
 direction display_get_direction(const char *title, int *available)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return GD_NONE;
+
     display_window *dwin;
 
     int *dirs = NULL;
@@ -2204,6 +2413,10 @@ position display_get_position(player *p,
                               gboolean passable,
                               gboolean visible)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return pos_invalid;
+
     /* start at player's position */
     position start = p->pos;
 
@@ -2271,6 +2484,10 @@ position display_get_new_position(player *p,
                                   gboolean passable,
                                   gboolean visible)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return pos_invalid;
+
     gboolean RUN = TRUE;
     direction dir = GD_NONE;
     position pos;
@@ -2281,7 +2498,8 @@ position display_get_new_position(player *p,
     GList *mlist = NULL, *miter = NULL;
 
     /* variables for ray or ball painting */
-    GList *r = NULL;      /* a ray position list */
+    position_span r;      /* the positions of a ray */
+    gboolean have_ray = FALSE;
     monster *m;
 
     /* check the starting position makes sense */
@@ -2304,20 +2522,12 @@ position display_get_new_position(player *p,
     if (ray && !pos_identical(p->pos, start))
     {
         /* paint a ray to validate the starting position */
-        r = map_ray(vmap, p->pos, pos);
-
-        if (r == NULL)
+        if (!map_ray(vmap, p->pos, pos, &r))
         {
             /* it's not possible to draw a ray between the points
                -> leave everything as it has been */
             pos = p->pos;
         }
-        else
-        {
-            /* position is valid */
-            g_list_free(r);
-            r = NULL;
-        }
     } /* ray starting position validity check */
 
     do
@@ -2346,15 +2556,18 @@ position display_get_new_position(player *p,
         /* redraw screen to erase previous modifications */
         display_paint_screen(p);
 
+        /* the map will be painted over below */
+        display_map_invalidate();
+
         /* reset npos to an invalid position */
         position npos = pos_invalid;
 
         /* draw a ray if the starting position is not the player's position */
         if (ray && !pos_identical(pos, p->pos))
         {
-            r = map_ray(vmap, p->pos, pos);
+            have_ray = map_ray(vmap, p->pos, pos, &r);
 
-            if (r == NULL)
+            if (!have_ray)
             {
                 /* It wasn't possible to paint a ray to the target position.
                    Revert to the player's position.*/
@@ -2362,7 +2575,7 @@ position display_get_new_position(player *p,
             }
         }
 
-        if (ray && (r != NULL))
+        if (ray && have_ray)
         {
             /* draw a line between source and target if told to */
             monster *target = map_get_monster_at(vmap, pos);
@@ -2371,12 +2584,10 @@ position display_get_new_position(player *p,
             else                                    attrs = LIGHTCYAN;
 
             attron(attrs);
-            GList *iter = r;
 
-            do
+            for (guint idx = 0; idx < r.len; idx++)
             {
-                position tpos;
-                pos_val(tpos) = GPOINTER_TO_UINT(iter->data);
+                position tpos = r.pos[idx];
 
                 /* skip the player's position */
                 if (pos_identical(p->pos, tpos))
@@ -2399,23 +2610,24 @@ position display_get_new_position(player *p,
                     /* a position with no or an invisible monster on it */
                     mvaaddch(Y(tpos), X(tpos), attrs, '*');
                 }
-            } while ((iter = iter->next));
+            }
 
-            g_list_free(r);
-            r = NULL;
+            have_ray = FALSE;
         }
         else if (ball && radius)
         {
             /* paint a ball if told to */
-            area *obstacles = map_get_obstacles(vmap, pos, radius, FALSE);
-            area *b = area_new_circle_flooded(pos, radius, obstacles);
+            area obstacles, b;
             position cursor = pos;
 
-            for (Y(cursor) = b->start_y; Y(cursor) < b->start_y + b->size_y; Y(cursor)++)
+            map_get_obstacles(vmap, pos, radius, FALSE, &obstacles);
+            area_init_circle_flooded(&b, pos, radius, &obstacles);
+
+            for (Y(cursor) = b.start_y; Y(cursor) < b.start_y + b.size_y; Y(cursor)++)
             {
-                for (X(cursor) = b->start_x; X(cursor) < b->start_x + b->size_x; X(cursor)++)
+                for (X(cursor) = b.start_x; X(cursor) < b.start_x + b.size_x; X(cursor)++)
                 {
-                    if (area_pos_get(b, cursor))
+                    if (area_pos_get(&b, cursor))
                     {
                         move(Y(cursor), X(cursor));
 
@@ -2434,7 +2646,6 @@ position display_get_new_position(player *p,
                     }
                 }
             }
-            area_destroy(b);
         }
         else
         {
@@ -2628,19 +2839,12 @@ position display_get_new_position(player *p,
             if (ray)
             {
                 /* paint a ray to validate the new position */
-                r = map_ray(vmap, p->pos, npos);
-
-                if (r == NULL)
+                if (!map_ray(vmap, p->pos, npos, &r))
                 {
                     /* it's not possible to draw a ray between the points
                        -> return to previous position */
                     npos = pos;
                 }
-                else
-                {
-                    g_list_free(r);
-                    r = NULL;
-                }
             }
 
             if (ball)
@@ -2682,7 +2886,8 @@ void display_show_history(message_log *log, const char *title)
     for (guint idx = log_length(log); idx > 0; idx--)
     {
         message_log_entry *le = log_get_entry(log, idx - 1);
-        g_string_append_printf(text, "%*d: %s\n", twidth, le->gtime, le->message);
+        g_string_append_printf(text, "%*d: %s\n", twidth, le->gtime,
+                               log_entry_text(log, le));
     }
 
     /* display the log */
@@ -2694,6 +2899,10 @@ void display_show_history(message_log *log, const char *title)
 
 int display_show_message(const char *title, const char *message, int indent)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return KEY_ESC;
+
     int key;
 
     /* Number of columns required for
@@ -2814,6 +3023,10 @@ int display_show_message(const char *title, const char *message, int indent)
 
 display_window *display_popup(int x1, int y1, int width, const char *title, const char *msg, int indent)
 {
+    /* nobody to ask */
+    if (!display_initialised)
+        return NULL;
+
     display_window *win;
     GPtrArray *text;
     int height;
@@ -2868,6 +3081,10 @@ display_window *display_popup(int x1, int y1, int width, const char *title, cons
 
 void display_window_destroy(display_window *dwin)
 {
+    /* popups are not shown without a display */
+    if (dwin == NULL)
+        return;
+
     del_panel(dwin->panel);
     delwin(dwin->window);
 
@@ -2916,7 +3133,22 @@ void display_windows_show()
 }
 
 int display_getch(WINDOW *win) {
-    int ch = wgetch(win ? win : stdscr);
+    int ch;
+
+    /* the keys of a recorded game */
+    if (replay_key_get(&ch))
+        return ch;
+
+    ch = wgetch(win ? win : stdscr);
+
+    if (ch == ERR && display_output != DB_CURSES)
+    {
+        /* the scripted input is exhausted */
+        display_shutdown();
+        g_printerr("End of input reached.\n");
+        exit(EXIT_SUCCESS);
+    }
+
 #ifdef SDLPDCURSES
         /* on SDL2 PDCurses, keys entered on the numeric keypad while num
            lock is enabled are returned twice. Hence we need to swallow
@@ -2927,6 +3159,10 @@ int display_getch(WINDOW *win) {
             ch = wgetch(win ? win : stdscr);
         }
 #endif
+
+    /* keep the key if the game is recorded */
+    replay_key_add(ch);
+
     return ch;
 }
 
@@ -3297,15 +3533,3 @@ static display_window *display_item_details(guint x1, guint y1, guint width,
 
     return idpop;
 }
-
-static void display_spheres_paint(sphere *s, player *p)
-{
-    /* check if sphere is on current level */
-    if (!(Z(s->pos) == Z(p->pos)))
-        return;
-
-    if (game_fullvis(nlarn) || fov_get(p->fv, s->pos))
-    {
-        mvaaddch(Y(s->pos), X(s->pos), MAGENTA, '0');
-    }
-}
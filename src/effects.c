@@ -23,7 +23,21 @@
 #include "effects.h"
 #include "game.h"
 #include "extdefs.h"
+#include "profile.h"
 #include "random.h"
+#include "timewheel.h"
+
+/* timers used to handle effect expiry */
+typedef enum effect_timer
+{
+    EFFECT_TIMER_EXPIRE,    /* the effect times out */
+    EFFECT_TIMER_WARN,      /* the effect is about to time out */
+} effect_timer;
+
+/* number of turns in advance the player is warned about fading effects */
+#define EFFECT_WARN_TURNS 5
+
+static void effect_timer_fire(const timewheel_entry *entry, gpointer data);
 
 static const effect_data effects[ET_MAX] =
 {
@@ -538,6 +552,7 @@ effect *effect_new(effect_t type)
     g_assert(type > ET_NONE && type < ET_MAX);
 
     ne = g_malloc0(sizeof(effect));
+    profile_alloc(PM_EFFECTS, sizeof(effect));
     ne->type = type;
     ne->start = game_turn(nlarn);
 
@@ -574,7 +589,9 @@ effect *effect_copy(effect *e)
     g_assert(e != NULL);
 
     ne = g_malloc(sizeof(effect));
+    profile_alloc(PM_EFFECTS, sizeof(effect));
     memcpy(ne, e, sizeof(effect));
+    ne->scheduled = 0;
 
     /* register copy with game */
     ne->oid = game_effect_register(nlarn, ne);
@@ -590,6 +607,7 @@ void effect_destroy(effect *e)
     game_effect_unregister(nlarn, e->oid);
 
     g_free(e);
+    profile_free(PM_EFFECTS, sizeof(effect));
 }
 
 void effect_serialize(gpointer oid, effect *e, cJSON *root)
@@ -601,7 +619,12 @@ void effect_serialize(gpointer oid, effect *e, cJSON *root)
     cJSON_AddNumberToObject(eval,"oid", GPOINTER_TO_UINT(oid));
     cJSON_AddNumberToObject(eval,"type", e->type);
     cJSON_AddNumberToObject(eval,"start", e->start);
-    cJSON_AddNumberToObject(eval,"turns", e->turns);
+
+    /* keep storing the remaining turns */
+    if (e->turns == 0 || effect_type_countdown(e->type))
+        cJSON_AddNumberToObject(eval,"turns", e->turns);
+    else
+        cJSON_AddNumberToObject(eval,"turns", max(effect_turns_left(e), 1));
     cJSON_AddNumberToObject(eval,"amount", e->amount);
 
     if (e->item)
@@ -617,6 +640,7 @@ effect *effect_deserialize(cJSON *eser, game *g)
     cJSON *itm;
 
     e = g_malloc0(sizeof(effect));
+    profile_alloc(PM_EFFECTS, sizeof(effect));
 
     oid = cJSON_GetObjectItem(eser, "oid")->valueint;
     e->oid =  GUINT_TO_POINTER(oid);
@@ -626,6 +650,10 @@ effect *effect_deserialize(cJSON *eser, game *g)
     e->turns = cJSON_GetObjectItem(eser, "turns")->valueint;
     e->amount = cJSON_GetObjectItem(eser, "amount")->valueint;
 
+    /* the duration of timed effects is counted from the start */
+    if (e->turns != 0 && !effect_type_countdown(e->type))
+        e->turns += game_turn(g) - e->start;
+
     if ((itm = cJSON_GetObjectItem(eser, "item")))
     {
         e->item = GUINT_TO_POINTER(itm->valueint);
@@ -694,6 +722,14 @@ gboolean effect_type_inc_duration(effect_t type)
     return effects[type].inc_duration;
 }
 
+gboolean effect_type_countdown(effect_t type)
+{
+    g_assert(type < ET_MAX);
+
+    /* these effects are counted down by actions, not by the game time */
+    return (type == ET_TRAPPED || type == ET_TIMESTOP);
+}
+
 gboolean effect_type_inc_amount(effect_t type)
 {
     g_assert(type < ET_MAX);
@@ -750,7 +786,11 @@ effect *effect_add(GPtrArray *ea, effect *ne)
         /* if the effect's duration can be extended, reset it */
         if (effects[e->type].inc_duration)
         {
-            e->turns = max(e->turns, ne->turns);
+            if (effect_type_countdown(e->type))
+                e->turns = max(e->turns, ne->turns);
+            else
+                e->turns = max(e->start + e->turns, ne->start + ne->turns)
+                           - e->start;
             modified_existing = TRUE;
         }
 
@@ -821,6 +861,51 @@ int effect_query(GPtrArray *ea, effect_t type)
     return amount;
 }
 
+void effect_summary_update(effect_summary *es, GPtrArray *ea, effect_t type)
+{
+    gint32 amount = 0;
+    gboolean active = FALSE;
+
+    g_assert(es != NULL && ea != NULL && type > ET_NONE && type < ET_MAX);
+
+    for (guint idx = 0; idx < ea->len; idx++)
+    {
+        effect *e = game_effect_get(nlarn, g_ptr_array_index(ea, idx));
+
+        if (e->type != type)
+            continue;
+
+        amount += e->amount;
+
+        if (e->item == NULL)
+            active = TRUE;
+    }
+
+    es->amount[type] = amount;
+
+    if (active)
+        es->active[type / 32] |= (1u << (type % 32));
+    else
+        es->active[type / 32] &= ~(1u << (type % 32));
+}
+
+void effect_summary_rebuild(effect_summary *es, GPtrArray *ea)
+{
+    g_assert(es != NULL && ea != NULL);
+
+    memset(es, 0, sizeof(effect_summary));
+
+    for (guint idx = 0; idx < ea->len; idx++)
+    {
+        effect *e = game_effect_get(nlarn, g_ptr_array_index(ea, idx));
+
+        es->amount[e->type] += e->amount;
+
+        if (e->item == NULL)
+            es->active[e->type / 32] |= (1u << (e->type % 32));
+    }
+}
+
 int effect_expire(effect *e)
 {
     g_assert(e != NULL);
@@ -836,3 +921,94 @@ int effect_expire(effect *e)
 
     return e->turns;
 }
+
+int effect_turns_left(effect *e)
+{
+    g_assert(e != NULL);
+
+    if (e->turns == 0 || effect_type_countdown(e->type))
+        return e->turns;
+
+    return (gint64)e->start + e->turns - game_turn(nlarn);
+}
+
+void effect_schedule(effect *e, gpointer owner)
+{
+    guint32 expiry;
+
+    g_assert(e != NULL);
+
+    if (e->turns == 0 || effect_type_countdown(e->type))
+        return;
+
+    expiry = e->start + e->turns;
+
+    /* the effect is already scheduled for this turn */
+    if (e->scheduled == expiry)
+        return;
+
+    e->scheduled = expiry;
+    timewheel_add(nlarn->effect_timers, expiry, EFFECT_TIMER_EXPIRE,
+                  e->oid, owner);
+
+    /* warn the player before critical effects time out */
+    if (owner == NULL && (e->type == ET_WALL_WALK || e->type == ET_LEVITATION)
+            && expiry - EFFECT_WARN_TURNS > game_turn(nlarn))
+    {
+        timewheel_add(nlarn->effect_timers, expiry - EFFECT_WARN_TURNS,
+                      EFFECT_TIMER_WARN, e->oid, owner);
+    }
+}
+
+void effects_expire(game *g)
+{
+    g_assert(g != NULL);
+
+    timewheel_advance(g->effect_timers, game_turn(g), effect_timer_fire, g);
+}
+
+static void effect_timer_fire(const timewheel_entry *entry, gpointer data)
+{
+    game *g = (game *)data;
+    effect *e = game_effect_get(g, entry->data1);
+
+    /* the effect has been destroyed in the meantime */
+    if (e == NULL)
+        return;
+
+    if (entry->kind == EFFECT_TIMER_WARN)
+    {
+        /* the duration of the effect has been changed */
+        if (e->scheduled != entry->when + EFFECT_WARN_TURNS)
+            return;
+
+        if (e->type == ET_WALL_WALK)
+            log_add_entry(g->log, "`lightred`Your attunement to the walls is fading!`end`");
+        else
+            log_add_entry(g->log, "`lightred`You are starting to drift towards the ground!`end`");
+
+        /* interrupt actions */
+        g->p->attacked = TRUE;
+
+        return;
+    }
+
+    /* the duration of the effect has been changed */
+    if (e->scheduled != entry->when)
+        return;
+
+    /* effects bound to items survive their removal */
+    e->scheduled = 0;
+
+    if (entry->data2 == NULL)
+    {
+        player_effect_del(g->p, e);
+    }
+    else
+    {
+        monster *m = game_monster_get(g, entry->data2);
+
+        if (m != NULL)
+            monster_effect_del(m, e);
+    }
+}
@@ -23,6 +23,7 @@
 #include "map.h"
 #include "extdefs.h"
 #include "position.h"
+#include "profile.h"
 
 static void fov_calculate_octant(fov *fv, map *m, position center,
                                  gboolean infravision, int row,
@@ -67,6 +68,8 @@ void fov_calculate(fov *fv, map *m, position pos, int radius, gboolean infravisi
         { 1,  0,  0,  1, -1,  0,  0, -1 }
     };
 
+    gint64 prof_start = profile_begin();
+
     /* reset the entire fov to unseen */
     fov_reset(fv);
 
@@ -83,6 +86,8 @@ void fov_calculate(fov *fv, map *m, position pos, int radius, gboolean infravisi
     }
 
     fov_set(fv, pos, TRUE, infravision, TRUE);
+
+    profile_end(PP_FOV_CALCULATE, prof_start);
 }
 
 gboolean fov_get(fov *fv, position pos)
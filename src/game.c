@@ -43,15 +43,50 @@
 #include "display.h"
 #include "game.h"
 #include "extdefs.h"
+#include "nlarn.h"
 #include "player.h"
+#include "profile.h"
 #include "spheres.h"
 #include "random.h"
 
+static void game_setup(struct game_config *config, gboolean restore, guint32 seed);
 static void game_new();
 static gboolean game_load();
 static void game_items_shuffle(game *g);
-
-/* file descriptor for locking the savegame file */
+static void game_monsters_move(game *g);
+static void game_monster_schedule(game *g, monster *m, guint32 now);
+
+/* see https://stackoverflow.com/q/36764885/1519878 */
+#define _STR(x) #x
+#define STR(x) _STR(x)
+
+/* version string */
+const char *nlarn_version = STR(VERSION_MAJOR) "." STR(VERSION_MINOR) "." STR(VERSION_PATCH) GITREV;
+
+/* the game the thread is working on */
+THREAD_LOCAL game *nlarn = NULL;
+
+/* death jump buffer - used to return to the main loop when the player has died */
+THREAD_LOCAL jmp_buf nlarn_death_jump;
+
+/* file paths */
+const char *nlarn_libdir = NULL;
+const char *nlarn_mesgfile = NULL;
+const char *nlarn_helpfile = NULL;
+const char *nlarn_mazefile = NULL;
+const char *nlarn_fortunes = NULL;
+const char *nlarn_highscores = NULL;
+const char *nlarn_inifile = NULL;
+const char *nlarn_savefile = NULL;
+
+/* names of the files in the library directory */
+static const char *mesgfile = "nlarn.msg";
+static const char *helpfile = "nlarn.hlp";
+static const char *mazefile = "maze";
+static const char *fortunes = "fortune";
+
+/* file descriptor for locking the savegame file; process-wide like the
+   save file itself, see game.h */
 static int sgfd = 0;
 
 static void print_welcome_message(gboolean newgame)
@@ -89,15 +124,49 @@ static int try_locking_savegame_file(FILE *sg)
     return fd;
 }
 
+void game_set_libdir(const char *libdir)
+{
+    nlarn_libdir = libdir;
+
+    nlarn_mesgfile = g_build_filename(nlarn_libdir, mesgfile, NULL);
+    nlarn_helpfile = g_build_filename(nlarn_libdir, helpfile, NULL);
+    nlarn_mazefile = g_build_filename(nlarn_libdir, mazefile, NULL);
+    nlarn_fortunes = g_build_filename(nlarn_libdir, fortunes, NULL);
+}
+
 void game_init(struct game_config *config)
+{
+    game_setup(config, TRUE, 0);
+}
+
+game *game_create(struct game_config *config, guint32 seed)
+{
+    game_setup(config, FALSE, seed);
+
+    return nlarn;
+}
+
+void game_set_current(game *g)
+{
+    nlarn = g;
+    rand_use_state(g ? &g->rng : NULL);
+}
+
+static void game_setup(struct game_config *config, gboolean restore, guint32 seed)
 {
     /* allocate space for game structure */
-    nlarn = g_malloc0(sizeof(game));
+    game_set_current(g_malloc0(sizeof(game)));
+    nlarn->item_generation = 1;
 
-    /* set autosave setting (default: TRUE) */
-    game_autosave(nlarn) = !config->no_autosave;
+    /* games that are not restored may be reproduced from their seed */
+    if (!restore)
+        rand_set_seed(seed);
 
-    if (!game_load())
+    /* set autosave setting (default: TRUE), games that have not been
+       restored from the save file must not overwrite it */
+    game_autosave(nlarn) = restore && !config->no_autosave;
+
+    if (!restore || !game_load())
     {
         /* set game parameters */
         game_difficulty(nlarn) = config->difficulty;
@@ -145,17 +214,47 @@ void game_init(struct game_config *config)
     }
 }
 
+static void game_release(game *g, game *prev)
+{
+    /* continue with the previous game unless it has just been destroyed */
+    game_set_current(prev == g ? NULL : prev);
+
+    for (int minstep = 0; minstep < MAP_MAX; minstep++)
+        for (int maxstep = 0; maxstep < MAP_MAX; maxstep++)
+            rand_alias_destroy(g->monster_samplers[minstep][maxstep]);
+
+    rand_alias_destroy(g->polymorph_sampler);
+    rand_alias_destroy(g->armour_sampler);
+    rand_alias_destroy(g->weapon_sampler);
+
+    if (g->item_desc_memos != NULL)
+        g_hash_table_destroy(g->item_desc_memos);
+
+    g_free(g->item_props);
+    g_free(g);
+}
+
 game *game_destroy(game *g)
 {
+    game *prev = nlarn;
+
     g_assert(g != NULL);
 
+    /* the destructors refer to the current game */
+    game_set_current(g);
+
+    /* monsters that died during the current turn are still linked into
+       their map's monster list, destroy them before the maps */
+    if (g->dead_monsters != NULL)
+        game_remove_dead_monsters(g);
+
     /* everything must go */
     for (int i = 0; i < MAP_MAX; i++)
     {
         if (g->maps[i] == NULL)
         {
             /* killed early during game initialisation */
-            g_free(g);
+            game_release(g, prev);
             return NULL;
         }
         map_destroy(g->maps[i]);
@@ -174,10 +273,13 @@ game *game_destroy(game *g)
     g_hash_table_destroy(g->effects);
     g_hash_table_destroy(g->monsters);
     g_ptr_array_free(g->dead_monsters, TRUE);
+    g_ptr_array_free(g->active_monsters, TRUE);
+    pqueue_destroy(g->monster_moves);
+    timewheel_destroy(g->effect_timers);
 
     g_ptr_array_foreach(g->spheres, (GFunc)sphere_destroy, g);
     g_ptr_array_free(g->spheres, TRUE);
-    g_free(g);
+    game_release(g, prev);
 
     return NULL;
 }
@@ -194,6 +296,8 @@ int game_save(game *g)
     if (display_available())
         win = display_popup(2, 2, 0, NULL, "Saving....", 0);
 
+    gint64 prof_start = profile_begin();
+
     save = cJSON_CreateObject();
 
     cJSON_AddNumberToObject(save, "nlarn_version", g->version);
@@ -273,9 +377,13 @@ int game_save(game *g)
     cJSON_AddItemToObject(save, "effects", obj = cJSON_CreateArray());
     g_hash_table_foreach(g->effects, (GHFunc)effect_serialize, obj);
 
-    /* add monsters */
+    /* add monsters in the order of the maps' monster lists */
     cJSON_AddItemToObject(save, "monsters", obj = cJSON_CreateArray());
-    g_hash_table_foreach(g->monsters, (GHFunc)monster_serialize, obj);
+    for (int idx = 0; idx < MAP_MAX; idx++)
+    {
+        for (monster *m = g->maps[idx]->mfirst; m; m = monster_map_next(m))
+            monster_serialize(monster_oid(m), m, obj);
+    }
 
     /* add spheres */
     if (g->spheres->len > 0)
@@ -286,6 +394,8 @@ int game_save(game *g)
 
     /* print save game into a string */
     char *sg = cJSON_Print(save);
+    gsize sglen = strlen(sg) + 1;
+    profile_alloc(PM_SAVE_BUFFERS, sglen);
 
     /* free memory claimed by JSON structures */
     cJSON_Delete(save);
@@ -314,6 +424,8 @@ int game_save(game *g)
     {
         log_add_entry(g->log, "Error opening save file \"%s\".", nlarn_savefile);
         free(sg);
+        profile_free(PM_SAVE_BUFFERS, sglen);
+        profile_end(PP_SAVE, prof_start);
         return FALSE;
     }
 
@@ -330,12 +442,17 @@ int game_save(game *g)
                 nlarn_savefile, gzerror(file, &err));
 
         free(sg);
+        profile_free(PM_SAVE_BUFFERS, sglen);
+        profile_end(PP_SAVE, prof_start);
         return FALSE;
     }
 
     free(sg);
+    profile_free(PM_SAVE_BUFFERS, sglen);
     gzclose(file);
 
+    profile_end(PP_SAVE, prof_start);
+
     /* if a pop-up message has been opened, destroy it here */
     if (win != NULL)
         display_window_destroy(win);
@@ -356,6 +473,8 @@ void game_spin_the_wheel(game *g)
 
     g_assert(g != NULL);
 
+    gint64 prof_start = profile_begin();
+
     /* add the player's speed to the player's movement points */
     nlarn->p->movement += player_get_speed(nlarn->p);
 
@@ -398,14 +517,13 @@ void game_spin_the_wheel(game *g)
     }
 
     /* deal damage cause by map tiles to player */
-    damage *dam = map_tile_damage(amap, g->p->pos,
-                                  player_effect(g->p, ET_LEVITATION));
+    damage dam;
 
-    if (dam != NULL)
+    if (map_tile_damage(amap, g->p->pos, player_effect(g->p, ET_LEVITATION), &dam))
         player_damage_take(g->p, dam, PD_MAP, map_tiletype_at(amap, g->p->pos));
 
-    /* move all monsters */
-    g_hash_table_foreach(g->monsters, (GHFunc)monster_move, g);
+    /* move the monsters near the player */
+    game_monsters_move(g);
 
     /* destroy all monsters that have been killed during this turn */
     game_remove_dead_monsters(g);
@@ -418,6 +536,15 @@ void game_spin_the_wheel(game *g)
 
     g->gtime++; /* count up the time  */
     log_set_time(g->log, g->gtime); /* adjust time for log entries */
+
+    /* remove effects that have timed out */
+    effects_expire(g);
+
+    profile_end(PP_TURN, prof_start);
+    profile_turn_end();
+
+    profile_trace_counter("monsters", g_hash_table_size(g->monsters));
+    profile_trace_counter("items", g_hash_table_size(g->items));
 }
 
 void game_remove_dead_monsters(game *g)
@@ -507,10 +634,16 @@ static void game_new()
     nlarn->effects = g_hash_table_new(&g_direct_hash, &g_direct_equal);
     nlarn->monsters = g_hash_table_new(&g_direct_hash, &g_direct_equal);
 
+    /* initialize the timers for effect expiry (needed by player_new) */
+    nlarn->effect_timers = timewheel_new(nlarn->gtime);
+
     /* initialize the array to store monsters that died during the turn */
     nlarn->dead_monsters = g_ptr_array_new_with_free_func(
             (GDestroyNotify)monster_destroy);
 
+    nlarn->active_monsters = g_ptr_array_new();
+    nlarn->monster_moves = pqueue_new();
+
     nlarn->spheres = g_ptr_array_new();
 
     /* generate player */
@@ -519,6 +652,9 @@ static void game_new()
     /* randomize unidentified item descriptions */
     game_items_shuffle(nlarn);
 
+    /* the first maze of the maze file is never chosen at random */
+    nlarn->maze_used[0] = TRUE;
+
     /* fill the store */
     building_dndstore_init();
 
@@ -574,7 +710,11 @@ static gboolean game_load()
      * alive. This ensures no two instances of the game can be started
      * from the user's saved game.
      */
-    sgfd = try_locking_savegame_file(file);
+    if (!sgfd)
+    {
+        /* the lock is already held if this process has saved the game */
+        sgfd = try_locking_savegame_file(file);
+    }
 
     /* open the file with zlib */
     gzFile sg = gzdopen(fileno(file), "rb");
@@ -585,6 +725,7 @@ static gboolean game_load()
 
     /* temporary buffer to store uncompressed save file content */
     char *sgbuf = g_malloc0(bufsize);
+    profile_alloc(PM_SAVE_BUFFERS, bufsize);
 
     if (!gzread(sg, sgbuf, bufsize))
     {
@@ -603,6 +744,7 @@ static gboolean game_load()
 
     /* throw away the buffer */
     g_free(sgbuf);
+    profile_free(PM_SAVE_BUFFERS, bufsize);
 
     /* check for save file incompatibility */
     gboolean compatible_version = FALSE;
@@ -707,6 +849,8 @@ static gboolean game_load()
     for (int idx = 0; idx < size; idx++)
         nlarn->book_desc_mapping[idx] = cJSON_GetArrayItem(obj, idx)->valueint;
 
+    item_properties_init();
+
     obj = cJSON_GetObjectItem(save, "monster_genocided");
     size = cJSON_GetArraySize(obj);
     g_assert(size == MT_MAX);
@@ -714,6 +858,9 @@ static gboolean game_load()
         nlarn->monster_genocided[idx] = cJSON_GetArrayItem(obj, idx)->valueint;
 
 
+    /* initialize the timers for effect expiry (have to follow the game time) */
+    nlarn->effect_timers = timewheel_new(nlarn->gtime);
+
     /* restore effects (have to come first) */
     nlarn->effects = g_hash_table_new(&g_direct_hash, &g_direct_equal);
     obj = cJSON_GetObjectItem(save, "effects");
@@ -768,6 +915,9 @@ static gboolean game_load()
     nlarn->dead_monsters = g_ptr_array_new_with_free_func(
             (GDestroyNotify)monster_destroy);
 
+    nlarn->active_monsters = g_ptr_array_new();
+    nlarn->monster_moves = pqueue_new();
+
 
     /* restore spheres */
     nlarn->spheres = g_ptr_array_new();
@@ -800,6 +950,79 @@ static gboolean game_load()
     return TRUE;
 }
 
+static void game_monsters_move(game *g)
+{
+    const int pmap = Z(g->p->pos);
+
+    /* Collect the monsters on the player's map and the adjacent maps first.
+       Monsters can change the map while moving, thus the maps' lists
+       must not be walked while the monsters are being moved. */
+    g_ptr_array_set_size(g->active_monsters, 0);
+
+    for (int nmap = 0; nmap < MAP_MAX; nmap++)
+    {
+        gboolean map_adjacent = (abs(nmap - pmap) <= 1)
+                                || (nmap == MAP_CMAX && pmap == 0);
+
+        if (!map_adjacent)
+            continue;
+
+        for (monster *m = g->maps[nmap]->mfirst; m; m = monster_map_next(m))
+            g_ptr_array_add(g->active_monsters, m);
+    }
+
+    g->visible_moves = 0;
+    pqueue_clear(g->monster_moves);
+
+    /* handle the per-turn events and schedule the first move of each monster */
+    for (guint idx = 0; idx < g->active_monsters->len; idx++)
+    {
+        monster *m = g_ptr_array_index(g->active_monsters, idx);
+
+        if (monster_turn_begin(m, g))
+            game_monster_schedule(g, m, 0);
+    }
+
+    /* Let the monsters move in the order of their wake-up times. Thus fast
+       monsters' moves are spread over the turn instead of happening all
+       at once. */
+    monster *m;
+    guint32 now;
+
+    while ((m = pqueue_pop(g->monster_moves, &now)))
+    {
+        gint64 prof_start = profile_begin();
+        gboolean acted = monster_act(m, g);
+        profile_end_tagged(PP_MONSTER_ACT, prof_start, "monster", monster_name(m),
+                           "action", monster_ai_desc[monster_action(m)], NULL);
+
+        if (!acted)
+            /* the monster died or has finished its turn early */
+            continue;
+
+        if (monster_in_sight(m))
+            g->visible_moves++;
+
+        game_monster_schedule(g, m, now);
+    }
+}
+
+static void game_monster_schedule(game *g, monster *m, guint32 now)
+{
+    int wakeup = monster_wakeup(m);
+
+    if (wakeup < 0)
+    {
+        /* no movement points left */
+        monster_turn_end(m);
+        return;
+    }
+
+    /* moves can not happen in the past, even if the monster's speed
+       has changed in the meantime */
+    pqueue_push(g->monster_moves, max((guint32)wakeup, now), m);
+}
+
 static void game_items_shuffle(game *g)
 {
     shuffle(g->amulet_material_mapping, AM_MAX, 0);
@@ -807,6 +1030,12 @@ static void game_items_shuffle(game *g)
     shuffle(g->ring_material_mapping, RT_MAX, 0);
     shuffle(g->scroll_desc_mapping, ST_MAX, 1);
     shuffle(g->book_desc_mapping, SP_MAX, 0);
+
+    /* the descriptions depend on the mappings */
+    if (g->item_desc_memos != NULL)
+        g_hash_table_remove_all(g->item_desc_memos);
+
+    item_properties_init();
 }
 
 void game_delete_savefile()
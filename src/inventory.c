@@ -17,6 +17,7 @@
  */
 
 #include <glib.h>
+#include <string.h>
 
 #include "amulets.h"
 #include "game.h"
@@ -24,6 +25,22 @@
 #include "items.h"
 #include "extdefs.h"
 #include "potions.h"
+#include "profile.h"
+
+/* items of the same type and id share a key in the stack index; all
+   further attributes are compared by item_compare(). The id of gold is
+   its amount, all gold piles share one key. */
+#define inv_stack_key(it) GUINT_TO_POINTER(((guint)(it)->type << 16) \
+                                           | ((it)->type == IT_GOLD ? 0 : (it)->id))
+
+/* local functions */
+static void inv_count_types(inventory *inv);
+static void inv_cache_add(inventory *inv, item *it);
+static void inv_cache_del(inventory *inv, item *it);
+static int inv_weight_calc(inventory *inv);
+static void inv_stacks_build(inventory *inv);
+static void inv_stacks_add(inventory *inv, item *it);
+static void inv_stacks_del(inventory *inv, gpointer oid);
 
 /* functions */
 
@@ -32,9 +49,11 @@ inventory *inv_new(gconstpointer owner)
     inventory *ninv;
 
     ninv = g_malloc0(sizeof(inventory));
+    profile_alloc(PM_INVENTORIES, sizeof(inventory));
     ninv->content = g_ptr_array_new();
 
     ninv->owner = owner;
+    ninv->counted = TRUE;
 
     return ninv;
 }
@@ -62,7 +81,11 @@ void inv_destroy(inventory *inv, gboolean special)
 
     g_ptr_array_free(inv->content, TRUE);
 
+    if (inv->stacks != NULL)
+        g_hash_table_destroy(inv->stacks);
+
     g_free(inv);
+    profile_free(PM_INVENTORIES, sizeof(inventory));
 }
 
 cJSON *inv_serialize(inventory *inv)
@@ -81,6 +104,7 @@ cJSON *inv_serialize(inventory *inv)
 inventory *inv_deserialize(cJSON *iser)
 {
     inventory *inv = g_malloc0(sizeof(inventory));
+    profile_alloc(PM_INVENTORIES, sizeof(inventory));
     inv->content = g_ptr_array_new();
 
     for (int idx = 0; idx < cJSON_GetArraySize(iser); idx++)
@@ -108,6 +132,8 @@ int inv_add(inventory **inv, item *it)
 {
     g_assert(inv != NULL && it != NULL && it->oid != NULL);
 
+    gint64 prof_start = profile_begin();
+
     /* create inventory if necessary */
     if (!(*inv))
     {
@@ -120,6 +146,7 @@ int inv_add(inventory **inv, item *it)
         /* call pre_add callback */
         if (!(*inv)->pre_add(*inv, it))
         {
+            profile_end(PP_INV_ADD, prof_start);
             return FALSE;
         }
     }
@@ -127,14 +154,25 @@ int inv_add(inventory **inv, item *it)
     /* stack stackable items */
     if (item_is_stackable(it->type))
     {
-        /* loop through items in the target inventory to find a similar item */
-        for (guint idx = 0; idx < inv_length(*inv); idx++)
+        GPtrArray *stack;
+
+        if ((*inv)->stacks == NULL)
+            inv_stacks_build(*inv);
+
+        /* only look at the items of the same type and id */
+        stack = g_hash_table_lookup((*inv)->stacks, inv_stack_key(it));
+
+        for (guint idx = 0; stack != NULL && idx < stack->len; idx++)
         {
-            item *i = inv_get(*inv, idx);
+            item *i = game_item_get(nlarn, g_ptr_array_index(stack, idx));
+
             /* compare the current item with the one which is to be added */
-            if (item_compare(i, it))
+            if (i != NULL && item_compare(i, it))
             {
                 /* just increase item count and release the original */
+                if ((*inv)->weight_gen == nlarn->item_generation)
+                    (*inv)->weight += item_weight(it);
+
                 i->count += it->count;
                 item_destroy(it);
 
@@ -149,6 +187,8 @@ int inv_add(inventory **inv, item *it)
     {
         /* add the item to the inventory if it has not already been added */
         g_ptr_array_add((*inv)->content, it->oid);
+        inv_stacks_add(*inv, it);
+        inv_cache_add(*inv, it);
     }
 
     /* call post_add callback */
@@ -157,6 +197,8 @@ int inv_add(inventory **inv, item *it)
         (*inv)->post_add(*inv, it);
     }
 
+    profile_end(PP_INV_ADD, prof_start);
+
     return inv_length(*inv);
 }
 
@@ -185,6 +227,8 @@ item *inv_del(inventory **inv, guint idx)
     }
 
     g_ptr_array_remove_index((*inv)->content, idx);
+    inv_stacks_del(*inv, itm->oid);
+    inv_cache_del(*inv, itm);
 
     if ((*inv)->post_del)
     {
@@ -214,6 +258,8 @@ int inv_del_element(inventory **inv, item *it)
     }
 
     g_ptr_array_remove((*inv)->content, it->oid);
+    inv_stacks_del(*inv, it->oid);
+    inv_cache_del(*inv, it);
 
     if ((*inv)->post_del)
     {
@@ -239,6 +285,13 @@ int inv_del_oid(inventory **inv, gpointer oid)
         return FALSE;
     }
 
+    inv_stacks_del(*inv, oid);
+
+    /* the item may already have been destroyed, thus the cached values
+       have to be rebuilt */
+    (*inv)->counted = FALSE;
+    (*inv)->weight_gen = 0;
+
     /* destroy inventory if empty and not owned by anybody */
     if (!inv_length(*inv) && !(*inv)->owner)
     {
@@ -249,6 +302,15 @@ int inv_del_oid(inventory **inv, gpointer oid)
     return TRUE;
 }
 
+void inv_item_rekey(inventory *inv, item *it, guint id)
+{
+    g_assert(inv != NULL && it != NULL);
+
+    inv_stacks_del(inv, it->oid);
+    it->id = id;
+    inv_stacks_add(inv, it);
+}
+
 void inv_erode(inventory **inv, item_erosion_type iet,
                gboolean visible, int (*ifilter)(item *))
 {
@@ -283,22 +345,75 @@ void inv_sort(inventory *inv, GCompareDataFunc compare_func, gpointer user_data)
 
 int inv_weight(inventory *inv)
 {
-    int sum = 0;
+    int sum;
 
     if (inv == NULL)
     {
         return 0;
     }
 
-    /* add contents weight */
-    for (guint idx = 0; idx < inv_length(inv); idx++)
+    /* recalculate the weight if an item has been modified */
+    if (inv->weight_gen != nlarn->item_generation)
+    {
+        inv->weight = inv_weight_calc(inv);
+        inv->weight_gen = nlarn->item_generation;
+    }
+
+    /* catch modifications of items without calling inv_items_changed() */
+    g_assert(inv->weight == inv_weight_calc(inv));
+
+    sum = inv->weight;
+
+    /* the weight of containers depends on their content */
+    if (inv_length_type(inv, IT_CONTAINER) > 0)
     {
-        sum += item_weight(inv_get(inv, idx));
+        for (guint idx = 0; idx < inv_length(inv); idx++)
+        {
+            item *it = inv_get(inv, idx);
+
+            if (it->type == IT_CONTAINER)
+                sum += item_weight(it);
+        }
     }
 
     return sum;
 }
 
+void inv_items_changed()
+{
+    nlarn->item_generation++;
+}
+
+guint inv_length_type(inventory *inv, item_t type)
+{
+    g_assert(type > IT_NONE && type < IT_MAX);
+
+    if (inv == NULL)
+        return 0;
+
+    if (!inv->counted)
+        inv_count_types(inv);
+
+    return inv->type_count[type];
+}
+
+item *inv_get_type(inventory *inv, guint idx, item_t type)
+{
+    /* avoid looking at all items if there is none of the given type */
+    if (idx >= inv_length_type(inv, type))
+        return NULL;
+
+    for (guint num = 0; num < inv_length(inv); num++)
+    {
+        item *i = inv_get(inv, num);
+
+        if (i->type == type && idx-- == 0)
+            return i;
+    }
+
+    return NULL;
+}
+
 guint inv_length_filtered(inventory *inv, int (*ifilter)(item *))
 {
     int count = 0;
@@ -360,3 +475,106 @@ item *inv_get_filtered(inventory *inv, guint idx, int (*ifilter)(item *))
     /* not found */
     return NULL;
 }
+
+static void inv_count_types(inventory *inv)
+{
+    memset(inv->type_count, 0, sizeof(inv->type_count));
+
+    for (guint idx = 0; idx < inv_length(inv); idx++)
+        inv->type_count[inv_get(inv, idx)->type]++;
+
+    inv->counted = TRUE;
+}
+
+static void inv_cache_add(inventory *inv, item *it)
+{
+    if (inv->counted)
+        inv->type_count[it->type]++;
+
+    if (inv->weight_gen == nlarn->item_generation && it->type != IT_CONTAINER)
+        inv->weight += item_weight(it);
+}
+
+static void inv_cache_del(inventory *inv, item *it)
+{
+    if (inv->counted)
+        inv->type_count[it->type]--;
+
+    if (inv->weight_gen == nlarn->item_generation && it->type != IT_CONTAINER)
+        inv->weight -= item_weight(it);
+}
+
+static int inv_weight_calc(inventory *inv)
+{
+    int weight = 0;
+
+    for (guint idx = 0; idx < inv_length(inv); idx++)
+    {
+        item *it = inv_get(inv, idx);
+
+        if (it->type != IT_CONTAINER)
+            weight += item_weight(it);
+    }
+
+    return weight;
+}
+
+static void inv_stacks_build(inventory *inv)
+{
+    inv->stacks = g_hash_table_new_full(&g_direct_hash, &g_direct_equal,
+                                        NULL, (GDestroyNotify)g_ptr_array_unref);
+
+    for (guint idx = 0; idx < inv_length(inv); idx++)
+        inv_stacks_add(inv, inv_get(inv, idx));
+}
+
+static void inv_stacks_add(inventory *inv, item *it)
+{
+    GPtrArray *stack;
+
+    /* the index does not exist yet or the item can not be stacked */
+    if (inv->stacks == NULL || !item_is_stackable(it->type))
+        return;
+
+    if (!(stack = g_hash_table_lookup(inv->stacks, inv_stack_key(it))))
+    {
+        stack = g_ptr_array_new();
+        g_hash_table_insert(inv->stacks, inv_stack_key(it), stack);
+    }
+
+    g_ptr_array_add(stack, it->oid);
+}
+
+static void inv_stacks_del(inventory *inv, gpointer oid)
+{
+    item *it;
+    GHashTableIter iter;
+    gpointer stack;
+
+    if (inv->stacks == NULL)
+        return;
+
+    /* The item may already have been destroyed, e.g. when it has been
+       stacked onto an item in another inventory. */
+    if ((it = game_item_get(nlarn, oid)))
+    {
+        if (!item_is_stackable(it->type))
+            return;
+
+        if ((stack = g_hash_table_lookup(inv->stacks, inv_stack_key(it)))
+                && g_ptr_array_remove_fast(stack, oid))
+        {
+            return;
+        }
+    }
+
+    /* The item is not listed under its key, e.g. when its id has been
+       changed without inv_item_rekey(); search all stacks. */
+    g_hash_table_iter_init(&iter, inv->stacks);
+
+    while (g_hash_table_iter_next(&iter, NULL, &stack))
+    {
+        if (g_ptr_array_remove_fast(stack, oid))
+            break;
+    }
+}
@@ -17,6 +17,7 @@
  */
 
 #include <glib.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "amulets.h"
@@ -30,6 +31,7 @@
 #include "extdefs.h"
 #include "player.h"
 #include "potions.h"
+#include "profile.h"
 #include "random.h"
 #include "rings.h"
 #include "scrolls.h"
@@ -38,6 +40,44 @@
 #include "weapons.h"
 
 static const char *item_desc_get(item *it, int known);
+static gchar *item_describe_text(item *it, gboolean known, gboolean singular,
+                                 gboolean definite);
+static int item_sort_key_compare(gconstpointer a, gconstpointer b);
+
+/* a precomputed key for item_sort() */
+typedef struct _item_sort_key
+{
+    item_t type;
+    const char *name;
+    guint pos;          /* position in the inventory before sorting */
+    gpointer oid;
+} item_sort_key;
+
+/* the last description of an item returned by item_describe() */
+typedef struct _item_desc_memo
+{
+    item state;         /* a copy of the item when it was described */
+    char *notes;
+    guint32 flags;      /* the arguments, see item_desc_flags() */
+    char *desc;
+} item_desc_memo;
+
+static guint32 item_desc_flags(gboolean known, gboolean singular,
+                               gboolean definite, gboolean blind)
+{
+    return (known ? 1 : 0) | (singular ? 2 : 0) | (definite ? 4 : 0)
+           | (blind ? 8 : 0);
+}
+
+static void item_desc_memo_destroy(gpointer data)
+{
+    item_desc_memo *memo = (item_desc_memo *)data;
+
+    profile_free(PM_ITEMS, sizeof(item_desc_memo) + strlen(memo->desc) + 1);
+    g_free(memo->notes);
+    g_free(memo->desc);
+    g_free(memo);
+}
 
 const item_type_data item_data[IT_MAX] =
 {
@@ -78,6 +118,39 @@ const item_material_data item_materials[IM_MAX] =
     { IM_GEMSTONE,    "gemstone",    "gemstone", RED,        0, },
 };
 
+/* the position of the first id of each item type in the table of item
+   properties; the last element is the size of the table */
+#define IP_MAX (AM_MAX + AMT_MAX + AT_MAX + SP_MAX + CT_MAX + GT_MAX + 1 \
+                + PO_MAX + RT_MAX + ST_MAX + WT_MAX)
+
+static const guint item_props_offset[IT_MAX + 1] =
+{
+    0,                                                  /* IT_NONE */
+    0,                                                  /* IT_AMULET */
+    AM_MAX,                                             /* IT_AMMO */
+    AM_MAX + AMT_MAX,                                   /* IT_ARMOUR */
+    AM_MAX + AMT_MAX + AT_MAX,                          /* IT_BOOK */
+    AM_MAX + AMT_MAX + AT_MAX + SP_MAX,                 /* IT_CONTAINER */
+    AM_MAX + AMT_MAX + AT_MAX + SP_MAX + CT_MAX,        /* IT_GEM */
+    IP_MAX - WT_MAX - ST_MAX - RT_MAX - PO_MAX - 1,     /* IT_GOLD */
+    IP_MAX - WT_MAX - ST_MAX - RT_MAX - PO_MAX,         /* IT_POTION */
+    IP_MAX - WT_MAX - ST_MAX - RT_MAX,                  /* IT_RING */
+    IP_MAX - WT_MAX - ST_MAX,                           /* IT_SCROLL */
+    IP_MAX - WT_MAX,                                    /* IT_WEAPON */
+    IP_MAX
+};
+
+static inline const item_properties *item_props_of(item *it)
+{
+    if (nlarn->item_props == NULL)
+        item_properties_init();
+
+    /* the id of gold is its amount, all gold shares the same properties */
+    guint id = (it->type == IT_GOLD) ? 0 : it->id;
+
+    return &nlarn->item_props[item_props_offset[it->type] + id];
+}
+
 /* functions */
 
 item *item_new(item_t item_type, int item_id)
@@ -90,6 +163,7 @@ item *item_new(item_t item_type, int item_id)
 
     /* has to be zeroed or memcmp will fail */
     nitem = g_malloc0(sizeof(item));
+    profile_alloc(PM_ITEMS, sizeof(item));
 
     nitem->type = item_type;
     nitem->id = item_id;
@@ -151,14 +225,27 @@ item *item_new(item_t item_type, int item_id)
 
     case IT_ARMOUR:
         /* ensure that unique armour isn't created multiple times */
-        while (nlarn->armour_created[nitem->id])
+        if (nlarn->armour_created[nitem->id])
         {
-            nitem->id = rand_0n(item_max_id(IT_ARMOUR));
+            if (nlarn->armour_sampler == NULL)
+            {
+                guint32 weights[AT_MAX];
+
+                for (guint id = 0; id < AT_MAX; id++)
+                    weights[id] = !nlarn->armour_created[id];
+
+                nlarn->armour_sampler = rand_alias_new(weights, AT_MAX);
+            }
+
+            nitem->id = rand_alias_draw(nlarn->armour_sampler);
         }
 
         if (armour_unique(nitem))
         {
             nlarn->armour_created[nitem->id] = TRUE;
+
+            rand_alias_destroy(nlarn->armour_sampler);
+            nlarn->armour_sampler = NULL;
         }
 
         if (armour_effect(nitem))
@@ -206,16 +293,29 @@ item *item_new(item_t item_type, int item_id)
         break;
 
     case IT_WEAPON:
-        while (weapon_is_unique(nitem) && nlarn->weapon_created[nitem->id])
+        if (weapon_is_unique(nitem) && nlarn->weapon_created[nitem->id])
         {
             /* create another random weapon instead */
-            nitem->id = rand_0n(WT_MAX);
+            if (nlarn->weapon_sampler == NULL)
+            {
+                guint32 weights[WT_MAX];
+
+                for (guint id = 0; id < WT_MAX; id++)
+                    weights[id] = !(weapons[id].unique && nlarn->weapon_created[id]);
+
+                nlarn->weapon_sampler = rand_alias_new(weights, WT_MAX);
+            }
+
+            nitem->id = rand_alias_draw(nlarn->weapon_sampler);
         }
 
         if (weapon_is_unique(nitem))
         {
             /* mark unique weapon as created */
             nlarn->weapon_created[nitem->id] = TRUE;
+
+            rand_alias_destroy(nlarn->weapon_sampler);
+            nlarn->weapon_sampler = NULL;
         }
 
         /* special effects for Bessman's Hammer */
@@ -391,6 +491,7 @@ item *item_copy(item *original)
 
     /* clone item */
     nitem = g_malloc0(sizeof(item));
+    profile_alloc(PM_ITEMS, sizeof(item));
     memcpy(nitem, original, sizeof(item));
 
     /* copy effects */
@@ -427,6 +528,7 @@ item *item_split(item *original, guint32 count)
 
     nitem->count = count;
     original->count -= count;
+    inv_items_changed();
 
     return nitem;
 }
@@ -460,10 +562,16 @@ void item_destroy(item *it)
         g_free(it->notes);
     }
 
+    if (nlarn->item_desc_memos != NULL)
+    {
+        g_hash_table_remove(nlarn->item_desc_memos, it->oid);
+    }
+
     /* unregister item */
     game_item_unregister(nlarn, it->oid);
 
     g_free(it);
+    profile_free(PM_ITEMS, sizeof(item));
 }
 
 void item_serialize(gpointer oid, gpointer it, gpointer root)
@@ -516,6 +624,7 @@ item *item_deserialize(cJSON *iser, struct game *g)
     cJSON *obj;
 
     it = g_malloc0(sizeof(item));
+    profile_alloc(PM_ITEMS, sizeof(item));
 
     /* must-have attributes */
     oid = cJSON_GetObjectItem(iser, "oid")->valueint;
@@ -609,28 +718,76 @@ int item_compare(item *a, item *b)
     return result;
 }
 
-int item_sort(gconstpointer a, gconstpointer b, gpointer data, gboolean force_id)
+void item_sort(inventory *inv, player *p, gboolean force_id)
 {
-    gint order;
-    item *item_a = game_item_get(nlarn, *((gpointer**)a));
-    item *item_b = game_item_get(nlarn, *((gpointer**)b));
-    player *p = (player *)data;
+    guint len = inv_length(inv);
+
+    if (len < 2)
+        return;
 
-    if (item_a->type == item_b->type)
+    /* look up the items and their names only once instead of
+       for every comparison */
+    item_sort_key *keys = g_new(item_sort_key, len);
+
+    for (guint idx = 0; idx < len; idx++)
     {
-        /* Both items are of identical type. Compare their names. */
-        order = g_ascii_strcasecmp(item_desc_get(item_a, force_id || player_item_known(p, item_a)),
-                                   item_desc_get(item_b, force_id || player_item_known(p, item_b)));
+        gpointer oid = g_ptr_array_index(inv->content, idx);
+        item *it = game_item_get(nlarn, oid);
+
+        keys[idx].type = it->type;
+        keys[idx].name = item_desc_get(it, force_id || player_item_known(p, it));
+        keys[idx].pos = idx;
+        keys[idx].oid = oid;
     }
-    else if (item_a->type < item_b->type)
-        order = -1;
-    else
-        order = 1;
 
-    return order;
+    qsort(keys, len, sizeof(item_sort_key), item_sort_key_compare);
+
+    for (guint idx = 0; idx < len; idx++)
+        g_ptr_array_index(inv->content, idx) = keys[idx].oid;
+
+    g_free(keys);
 }
 
 gchar *item_describe(item *it, gboolean known, gboolean singular, gboolean definite)
+{
+    g_assert((it != NULL) && (it->type > IT_NONE) && (it->type < IT_MAX));
+
+    gboolean blind = (nlarn->p && player_effect_get(nlarn->p, ET_BLINDNESS));
+    guint32 flags = item_desc_flags(known, singular, definite, blind);
+
+    /* item oid -> item_desc_memo */
+    if (nlarn->item_desc_memos == NULL)
+    {
+        nlarn->item_desc_memos = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                       NULL, item_desc_memo_destroy);
+    }
+
+    /* the inventory dialogues describe the same items over and over again;
+       the description does not change as long as neither the item nor
+       the arguments change */
+    item_desc_memo *memo = g_hash_table_lookup(nlarn->item_desc_memos, it->oid);
+
+    if (memo != NULL && memo->flags == flags
+            && memcmp(&memo->state, it, sizeof(item)) == 0
+            && g_strcmp0(memo->notes, it->notes) == 0)
+    {
+        return g_strdup(memo->desc);
+    }
+
+    memo = g_new(item_desc_memo, 1);
+    memcpy(&memo->state, it, sizeof(item));
+    memo->notes = g_strdup(it->notes);
+    memo->flags = flags;
+    memo->desc = item_describe_text(it, known, singular, definite);
+    profile_alloc(PM_ITEMS, sizeof(item_desc_memo) + strlen(memo->desc) + 1);
+
+    g_hash_table_replace(nlarn->item_desc_memos, it->oid, memo);
+
+    return g_strdup(memo->desc);
+}
+
+static gchar *item_describe_text(item *it, gboolean known, gboolean singular,
+                                 gboolean definite)
 {
     GString *desc = g_string_new(NULL);
 
@@ -853,118 +1010,134 @@ gchar *item_describe(item *it, gboolean known, gboolean singular, gboolean defin
     return g_string_free(desc, FALSE);
 }
 
-item_material_t item_material(item *it)
+void item_properties_init()
 {
-    g_assert (it != NULL);
+    if (nlarn->item_props == NULL)
+        nlarn->item_props = g_new0(item_properties, IP_MAX);
 
-    switch (it->type)
+    for (item_t type = IT_AMULET; type < IT_MAX; type++)
     {
-    case IT_AMULET:
-        return amulet_material(it->id);
-        break;
-
-    case IT_AMMO:
-        return ammo_material(it);
-        break;
+        guint count = item_props_offset[type + 1] - item_props_offset[type];
 
-    case IT_ARMOUR:
-        return armour_material(it);
-        break;
-
-    case IT_BOOK:
-        return IM_PAPER;
-        break;
-
-    case IT_CONTAINER:
-        return container_material(it);
-        break;
-
-    case IT_GEM:
-        return IM_GEMSTONE;
-        break;
-
-    case IT_GOLD:
-        return IM_GOLD;
-        break;
+        for (guint id = 0; id < count; id++)
+        {
+            item_properties *ip = &nlarn->item_props[item_props_offset[type] + id];
 
-    case IT_POTION:
-        return IM_GLASS;
-        break;
+            /* the type specific functions expect an item */
+            item it = { 0 };
+            it.type = type;
+            it.id = id;
+            it.bonus = 1;
+            it.count = 1;
 
-    case IT_RING:
-        return ring_material(it->id);
-        break;
+            switch (type)
+            {
+            case IT_AMULET:
+                ip->price = amulet_price(&it);
+                ip->weight = 150;
+                ip->material = amulet_material(id);
+                ip->colour = item_materials[ip->material].colour;
+                break;
+
+            case IT_AMMO:
+                ip->price = ammo_price(&it);
+                ip->weight = ammo_weight(&it);
+                ip->material = ammo_material(&it);
+                ip->colour = item_materials[ip->material].colour;
+                break;
+
+            case IT_ARMOUR:
+                ip->price = armour_price(&it);
+                ip->weight = armour_weight(&it);
+                ip->material = armour_material(&it);
+                ip->colour = item_materials[ip->material].colour;
+                break;
+
+            case IT_BOOK:
+                ip->price = book_price(&it);
+                ip->weight = book_weight(&it);
+                ip->material = IM_PAPER;
+                ip->colour = book_colour(&it);
+                break;
+
+            case IT_CONTAINER:
+                ip->price = container_price(&it);
+                ip->weight = container_weight(&it);
+                ip->material = container_material(&it);
+                ip->colour = BROWN;
+                break;
+
+            case IT_GEM:
+                /* the price of a single carat */
+                ip->price = gem_price(&it);
+                ip->material = IM_GEMSTONE;
+                ip->colour = gem_colour(&it);
+                break;
+
+            case IT_GOLD:
+                /* Is this too heavy? Is this too light?
+                   It should give the player a reason to use the bank. */
+                ip->weight = 4;
+                ip->material = IM_GOLD;
+                ip->colour = YELLOW;
+                break;
+
+            case IT_POTION:
+                ip->price = potion_price(&it);
+                ip->weight = 250;
+                ip->material = IM_GLASS;
+                ip->colour = potion_colour(id);
+                break;
+
+            case IT_RING:
+                ip->price = ring_price(&it);
+                ip->weight = 10;
+                ip->material = ring_material(id);
+                ip->colour = item_materials[ip->material].colour;
+                break;
+
+            case IT_SCROLL:
+                ip->price = scroll_price(&it);
+                ip->weight = 100;
+                ip->material = IM_PAPER;
+                ip->colour = WHITE;
+                break;
+
+            case IT_WEAPON:
+                ip->price = weapon_price(&it);
+                ip->weight = weapon_weight(&it);
+                ip->material = weapon_material(&it);
+                ip->colour = item_materials[ip->material].colour;
+
+                /* Ensure that unique weapons do not break */
+                ip->unbreakable = weapon_is_unique(&it);
+                break;
+
+            default:
+                break;
+            }
 
-    case IT_SCROLL:
-        return IM_PAPER;
-        break;
+            ip->fragility = item_materials[ip->material].fragility;
+        }
+    }
+}
 
-    case IT_WEAPON:
-        return weapon_material(it);
-        break;
+item_material_t item_material(item *it)
+{
+    g_assert (it != NULL);
 
-    default:
-        g_assert(0);
-        /* required to silence a release mode warning */
-        return IM_MAX;
-    }
+    return item_props_of(it)->material;
 }
 
 guint item_base_price(item *it)
 {
     g_assert (it != NULL && it->type > IT_NONE && it->type < IT_MAX);
 
-    guint price;
-
-    switch (it->type)
-    {
-    case IT_AMULET:
-        price = amulet_price(it);
-        break;
-
-    case IT_AMMO:
-        price = ammo_price(it);
-        break;
-
-    case IT_ARMOUR:
-        price = armour_price(it);
-        break;
-
-    case IT_BOOK:
-        price = book_price(it);
-        break;
-
-    case IT_CONTAINER:
-        price = container_price(it);
-        break;
-
-    case IT_GEM:
-        price = gem_price(it);
-        break;
-
-    case IT_GOLD:
-        price = 0;
-        break;
+    guint price = item_props_of(it)->price;
 
-    case IT_POTION:
-        price = potion_price(it);
-        break;
-
-    case IT_RING:
-        price = ring_price(it);
-        break;
-
-    case IT_SCROLL:
-        price = scroll_price(it);
-        break;
-
-    case IT_WEAPON:
-        price = weapon_price(it);
-        break;
-
-    default:
-        price = 0;
-    }
+    /* the price of gems depends on their size */
+    if (it->type == IT_GEM)
+        price *= gem_size(it);
 
     return price;
 }
@@ -1013,62 +1186,15 @@ guint item_price(item *it)
 
 int item_weight(item *it)
 {
-    int weight = 0;
-
     g_assert(it != NULL && it->type > IT_NONE && it->type < IT_MAX);
 
-    switch (it->type)
-    {
-    case IT_AMULET:
-        weight = 150;
-        break;
-
-    case IT_AMMO:
-        weight =  ammo_weight(it);
-        break;
-
-    case IT_ARMOUR:
-        weight =  armour_weight(it);
-        break;
-
-    case IT_BOOK:
-        weight =  book_weight(it);
-        break;
-
-    case IT_POTION:
-        weight =  250;
-        break;
-
-    case IT_RING:
-        weight =  10;
-        break;
-
-    case IT_SCROLL:
-        weight =  100;
-        break;
-
-    case IT_CONTAINER:
-        weight = container_weight(it) + inv_weight(it->content);
-        break;
-
-    case IT_GOLD:
-        /* Is this too heavy? Is this too light?
-           It should give the player a reason to use the bank. */
-        weight =  4;
-        break;
+    int weight = item_props_of(it)->weight;
 
-    case IT_GEM:
-        weight =  gem_weight(it);
-        break;
-
-    case IT_WEAPON:
-        weight =  weapon_weight(it);
-        break;
+    if (it->type == IT_GEM)
+        weight = gem_weight(it);
 
-    default:
-        weight =  0;
-        break;
-    }
+    if (it->type == IT_CONTAINER)
+        weight += inv_weight(it->content);
 
     if (item_is_stackable(it->type))
         weight = weight * it->count;
@@ -1080,54 +1206,18 @@ int item_colour(item *it)
 {
     g_assert(it != NULL && it->type > IT_NONE && it->type < IT_MAX);
 
-    switch (it->type)
-    {
-    case IT_AMULET:
-    case IT_AMMO:
-    case IT_ARMOUR:
-    case IT_RING:
-    case IT_WEAPON:
-        return item_materials[item_material(it)].colour;
-        break;
-
-    case IT_BOOK:
-        return book_colour(it);
-        break;
-
-    case IT_POTION:
-        return potion_colour(it->id);
-        break;
-
-    case IT_SCROLL:
-        return WHITE;
-        break;
-
-    case IT_CONTAINER:
-        return BROWN;
-        break;
-
-    case IT_GOLD:
-        return YELLOW;
-        break;
-
-    case IT_GEM:
-        return gem_colour(it);
-        break;
-
-    default:
-        return BLACK;
-        break;
-    }
+    return item_props_of(it)->colour;
 }
 
 guint item_fragility(item *it)
 {
-    int probability = item_materials[item_material(it)].fragility;
+    const item_properties *ip = item_props_of(it);
 
-    /* Ensure that unique weapons do not break */
-    if (it->type == IT_WEAPON && weapon_is_unique(it))
+    if (ip->unbreakable)
         return 0;
 
+    int probability = ip->fragility;
+
     probability += 15 * it->burnt;
     probability += 15 * it->corroded;
     probability += 15 * it->rusty;
@@ -1204,6 +1294,9 @@ item *item_enchant(item *it)
 
     it->bonus++;
 
+    /* the item might be a worn piece of armour */
+    player_modifiers_invalidate(nlarn->p);
+
     /* warn against over-enchantment */
     if (it->bonus == 3)
     {
@@ -1237,6 +1330,9 @@ item *item_enchant(item *it)
             effect *e = game_effect_get(nlarn, oid);
 
             e->amount++;
+
+            /* keep the summary up to date if the ring is worn */
+            effect_summary_update(&nlarn->p->esummary, nlarn->p->effects, e->type);
         }
     }
 
@@ -1254,6 +1350,7 @@ item *item_disenchant(item *it)
     }
 
     it->bonus--;
+    player_modifiers_invalidate(nlarn->p);
 
     if (it->bonus == -3)
     {
@@ -1275,6 +1372,9 @@ item *item_disenchant(item *it)
             effect *e = game_effect_get(nlarn, oid);
 
             e->amount--;
+
+            /* keep the summary up to date if the ring is worn */
+            effect_summary_update(&nlarn->p->esummary, nlarn->p->effects, e->type);
         }
     }
 
@@ -1377,6 +1477,12 @@ item *item_erode(inventory **inv, item *it, item_erosion_type iet, gboolean visi
         break;
     }
 
+    if (erosion_desc != NULL && inv != NULL && *inv == nlarn->p->inventory)
+    {
+        /* the item might be a worn piece of armour */
+        player_modifiers_invalidate(nlarn->p);
+    }
+
     if (erosion_desc != NULL && visible)
     {
         /* items has been eroded, describe the event if it is visible */
@@ -1685,6 +1791,24 @@ gboolean item_is_unique(item *it)
     }
 }
 
+static int item_sort_key_compare(gconstpointer a, gconstpointer b)
+{
+    const item_sort_key *key_a = (const item_sort_key *)a;
+    const item_sort_key *key_b = (const item_sort_key *)b;
+
+    if (key_a->type != key_b->type)
+        return (key_a->type < key_b->type) ? -1 : 1;
+
+    /* Both items are of identical type. Compare their names. */
+    gint order = g_ascii_strcasecmp(key_a->name, key_b->name);
+
+    if (order != 0)
+        return order;
+
+    /* keep the previous order of equally named items */
+    return (key_a->pos < key_b->pos) ? -1 : 1;
+}
+
 static const char *item_desc_get(item *it, int known)
 {
     g_assert(it != NULL && it->type > IT_NONE && it->type < IT_MAX);
@@ -24,6 +24,7 @@
 #include "items.h"
 #include "map.h"
 #include "extdefs.h"
+#include "profile.h"
 #include "random.h"
 #include "sobjects.h"
 #include "spheres.h"
@@ -40,6 +41,107 @@ static void map_make_lake(map *m, map_tile_t laketype);
 static void map_make_treasure_room(map *m, rectangle **rooms);
 static int map_validate(map *m);
 
+/*
+ * Rays follow Bresenham's line algorithm. As a line only depends on the
+ * distance between its ends, the lines for all distances within the map's
+ * bounds are calculated once. For every step along the major axis of a
+ * line, the offset on the minor axis is stored.
+ */
+static gint8 *map_ray_offsets = NULL;
+static guint32 map_ray_start[2 * MAP_MAX_Y - 1][2 * MAP_MAX_X - 1];
+
+static void map_rays_init()
+{
+    static gsize initialised = 0;
+
+    if (!g_once_init_enter(&initialised))
+        return;
+
+    gsize size = 0;
+
+    for (int dy = 1 - MAP_MAX_Y; dy < MAP_MAX_Y; dy++)
+        for (int dx = 1 - MAP_MAX_X; dx < MAP_MAX_X; dx++)
+            size += max(abs(dx), abs(dy));
+
+    gint8 *offsets = g_malloc(size);
+    guint32 used = 0;
+
+    for (int dy = 1 - MAP_MAX_Y; dy < MAP_MAX_Y; dy++)
+    {
+        for (int dx = 1 - MAP_MAX_X; dx < MAP_MAX_X; dx++)
+        {
+            int delta_x = abs(dx) << 1;
+            int delta_y = abs(dy) << 1;
+
+            /* if x1 == x2 or y1 == y2, then it does not matter what we set here */
+            int inc_x = dx > 0 ? 1 : -1;
+            int inc_y = dy > 0 ? 1 : -1;
+
+            int x = 0, y = 0;
+
+            map_ray_start[dy + MAP_MAX_Y - 1][dx + MAP_MAX_X - 1] = used;
+
+            if (delta_x >= delta_y)
+            {
+                /* error may go below zero */
+                int error = delta_y - (delta_x >> 1);
+
+                while (x != dx)
+                {
+                    if (error >= 0)
+                    {
+                        if (error || (inc_x > 0))
+                        {
+                            y += inc_y;
+                            error -= delta_x;
+                        }
+                    }
+
+                    x += inc_x;
+                    error += delta_y;
+
+                    offsets[used++] = y;
+                }
+            }
+            else
+            {
+                /* error may go below zero */
+                int error = delta_x - (delta_y >> 1);
+
+                while (y != dy)
+                {
+                    if (error >= 0)
+                    {
+                        if (error || (inc_y > 0))
+                        {
+                            x += inc_x;
+                            error -= delta_y;
+                        }
+                    }
+
+                    y += inc_y;
+                    error += delta_x;
+
+                    offsets[used++] = x;
+                }
+            }
+        }
+    }
+
+    map_ray_offsets = offsets;
+    g_once_init_leave(&initialised, 1);
+}
+
+/* the minor axis offsets of the line from (0, 0) to (dx, dy) */
+static inline const gint8 *map_ray_line(int dx, int dy)
+{
+    g_assert(abs(dx) < MAP_MAX_X && abs(dy) < MAP_MAX_Y);
+
+    map_rays_init();
+
+    return map_ray_offsets + map_ray_start[dy + MAP_MAX_Y - 1][dx + MAP_MAX_X - 1];
+}
+
 static inline void map_sphere_destroy(sphere *s, map *m __attribute__((unused)))
 {
     sphere_destroy(s, nlarn);
@@ -62,9 +164,6 @@ const map_tile_data map_tiles[LT_MAX] =
     { LT_WALL,      '#', LIGHTGRAY,  "a wall",      0, 0 },
 };
 
-/* keep track which levels have been used before */
-static int map_used[MAP_MAZE_NUM + 1] = { 1, 0 };
-
 const char *map_names[MAP_MAX] =
 {
     "Town",
@@ -108,6 +207,7 @@ map *map_new(int num, const char *mazefile)
     gboolean map_loaded = FALSE;
 
     map *nmap = nlarn->maps[num] = g_malloc0(sizeof(map));
+    profile_alloc(PM_MAPS, sizeof(map));
     nmap->nlevel = num;
 
     /* create map */
@@ -231,6 +331,7 @@ map *map_deserialize(cJSON *mser)
     map *m;
 
     m = g_malloc0(sizeof(map));
+    profile_alloc(PM_MAPS, sizeof(map));
 
     m->nlevel = cJSON_GetObjectItem(mser, "nlevel")->valueint;
     m->visited = cJSON_GetObjectItem(mser, "visited")->valueint;
@@ -316,24 +417,20 @@ void map_destroy(map *m)
     /* destroy spheres on this level */
     g_ptr_array_foreach(nlarn->spheres, (GFunc)map_sphere_destroy, m);
 
-    /* destroy items and monsters */
+    /* destroy monsters */
+    while (m->mfirst != NULL)
+        monster_destroy(m->mfirst);
+
+    /* destroy items */
     for (int y = 0; y < MAP_MAX_Y; y++)
         for (int x = 0; x < MAP_MAX_X; x++)
         {
-            if (m->grid[y][x].m_oid != NULL) {
-                monster *mon = game_monster_get(nlarn, m->grid[y][x].m_oid);
-
-                /* I wonder why it is possible that a monster ID is stored at
-                 * a position while there is no matching monster registered.
-                 * This seems to occur when called by game_destroy(). */
-                if (mon != NULL) monster_destroy(mon);
-            }
-
             if (m->grid[y][x].ilist != NULL)
                 inv_destroy(m->grid[y][x].ilist, TRUE);
         }
 
     g_free(m);
+    profile_free(PM_MAPS, sizeof(map));
 }
 
 /* return coordinates of a free space */
@@ -518,157 +615,73 @@ gboolean map_pos_validate(map *m, position pos, map_element_t element,
 
 int map_pos_is_visible(map *m, position s, position t)
 {
-    int delta_x, delta_y;
-    int x, y;
-    signed int ix, iy;
-
     /* positions on different levels? */
     if (Z(s) != Z(t))
         return FALSE;
 
-    x = X(s);
-    y = Y(s);
-
-    delta_x = abs(X(t) - X(s)) << 1;
-    delta_y = abs(Y(t) - Y(s)) << 1;
+    const int dx = X(t) - X(s);
+    const int dy = Y(t) - Y(s);
+    const int steps = max(abs(dx), abs(dy));
+    const gint8 *line = map_ray_line(dx, dy);
 
-    /* if x1 == x2 or y1 == y2, then it does not matter what we set here */
-    ix = X(t) > X(s) ? 1 : -1;
-    iy = Y(t) > Y(s) ? 1 : -1;
-
-    if (delta_x >= delta_y)
+    for (int step = 1; step <= steps; step++)
     {
-        /* error may go below zero */
-        int error = delta_y - (delta_x >> 1);
+        int x, y;
 
-        while (x != X(t))
+        if (abs(dx) >= abs(dy))
         {
-            if (error >= 0)
-            {
-                if (error || (ix > 0))
-                {
-                    y += iy;
-                    error -= delta_x;
-                }
-            }
-
-            x += ix;
-            error += delta_y;
-
-            if (!mt_is_transparent(m->grid[y][x].type)
-                    || !so_is_transparent(m->grid[y][x].sobject))
-            {
-                return FALSE;
-            }
+            x = X(s) + (dx > 0 ? step : -step);
+            y = Y(s) + line[step - 1];
         }
-    }
-    else
-    {
-        /* error may go below zero */
-        int error = delta_x - (delta_y >> 1);
-
-        while (y != Y(t))
+        else
         {
-            if (error >= 0)
-            {
-                if (error || (iy > 0))
-                {
-                    x += ix;
-                    error -= delta_y;
-                }
-            }
-
-            y += iy;
-            error += delta_x;
+            x = X(s) + line[step - 1];
+            y = Y(s) + (dy > 0 ? step : -step);
+        }
 
-            if (!mt_is_transparent(m->grid[y][x].type)
-                    || !so_is_transparent(m->grid[y][x].sobject))
-            {
-                return FALSE;
-            }
+        if (!mt_is_transparent(m->grid[y][x].type)
+                || !so_is_transparent(m->grid[y][x].sobject))
+        {
+            return FALSE;
         }
     }
 
     return TRUE;
 }
 
-GList *map_ray(map *m, position source, position target)
+gboolean map_ray(map *m, position source, position target, position_span *ray)
 {
-    GList *ray = NULL;
-    int delta_x, delta_y;
-    int inc_x, inc_y;
+    const int dx = X(target) - X(source);
+    const int dy = Y(target) - Y(source);
+    const int steps = max(abs(dx), abs(dy));
+    const gint8 *line = map_ray_line(dx, dy);
     position pos = source;
 
     /* Insert the source position */
-    ray = g_list_append(ray, GUINT_TO_POINTER(source.val));
-
-    delta_x = abs(X(target) - X(source)) << 1;
-    delta_y = abs(Y(target) - Y(source)) << 1;
-
-    /* if x1 == x2 or y1 == y2, then it does not matter what we set here */
-    inc_x = X(target) > X(source) ? 1 : -1;
-    inc_y = Y(target) > Y(source) ? 1 : -1;
+    ray->pos[0] = source;
+    ray->len = 1;
 
-    if (delta_x >= delta_y)
+    for (int step = 1; step <= steps; step++)
     {
-        /* error may go below zero */
-        int error = delta_y - (delta_x >> 1);
-
-        while (X(pos) != X(target))
+        if (abs(dx) >= abs(dy))
         {
-            if (error >= 0)
-            {
-                if (error || (inc_x > 0))
-                {
-                    Y(pos) += inc_y;
-                    error -= delta_x;
-                }
-            }
-
-            X(pos) += inc_x;
-            error += delta_y;
-
-            /* append even the last position to the list */
-            ray = g_list_append(ray, GUINT_TO_POINTER(pos.val));
-
-            if (!map_pos_transparent(m, pos))
-                break; /* stop following ray */
+            X(pos) = X(source) + (dx > 0 ? step : -step);
+            Y(pos) = Y(source) + line[step - 1];
         }
-    }
-    else
-    {
-        /* error may go below zero */
-        int error = delta_x - (delta_y >> 1);
-
-        while (Y(pos) != Y(target))
+        else
         {
-            if (error >= 0)
-            {
-                if (error || (inc_y > 0))
-                {
-                    X(pos) += inc_x;
-                    error -= delta_y;
-                }
-            }
-
-            Y(pos) += inc_y;
-            error += delta_x;
-
-            /* append even the last position to the list */
-            ray = g_list_append(ray, GUINT_TO_POINTER(pos.val));
-
-            if (!map_pos_transparent(m, pos))
-                break; /* stop following ray */
+            X(pos) = X(source) + line[step - 1];
+            Y(pos) = Y(source) + (dy > 0 ? step : -step);
         }
-    }
 
-    if (ray && GPOINTER_TO_UINT(g_list_last(ray)->data) != target.val)
-    {
-        g_list_free(ray);
-        ray = NULL;
+        /* append even the last position to the ray */
+        ray->pos[ray->len++] = pos;
+
+        if (!map_pos_transparent(m, pos))
+            break; /* stop following ray */
     }
 
-    return ray;
+    return pos_identical(ray->pos[ray->len - 1], target);
 }
 
 gboolean map_trajectory(position source, position target,
@@ -680,28 +693,24 @@ gboolean map_trajectory(position source, position target,
     g_assert(pos_valid(source) && pos_valid(target));
 
     map *tmap = game_map(nlarn, Z(source));
-
-    /* get the ray */
-    GList *ray = map_ray(tmap, source, target);
-    GList *iter = ray;
+    position_span ray;
 
     /* it was impossible to get a ray for the given positions */
-    if (!ray)
+    if (!map_ray(tmap, source, target, &ray))
         return FALSE;
 
     /* follow the ray to determine if it hits something */
-    do
+    for (guint idx = 0; idx < ray.len; idx++)
     {
         gboolean result = FALSE;
-        position cursor;
-        pos_val(cursor) = GPOINTER_TO_UINT(iter->data);
+        position cursor = ray.pos[idx];
 
         /* skip the source position */
         if (pos_identical(source, cursor))
             continue;
 
         /* the position is affected, call the callback function */
-        if (pos_hitfun(iter, damo, data1, data2))
+        if (pos_hitfun(&ray, idx, damo, data1, data2))
         {
             /* the callback returned that the ray if finished */
             result = TRUE;
@@ -712,7 +721,6 @@ gboolean map_trajectory(position source, position target,
                 || (pos_identical(cursor, nlarn->p->pos)
                             && player_effect(nlarn->p, ET_REFLECTION))))
         {
-            g_list_free(ray);
             /* repaint the screen before showing the reflection, otherwise
              * the reflection wouldn't be visible! */
             display_paint_screen(nlarn->p);
@@ -725,44 +733,33 @@ gboolean map_trajectory(position source, position target,
            callback indicated success */
         if (result == TRUE)
         {
-            g_list_free(ray);
             return result;
         }
 
         /* show the position of the ray*/
-        /* FIXME: move curses functions to display.c */
-        attron(colour);
-        (void)mvaddch(Y(cursor), X(cursor), glyph);
-        attroff(colour);
+        display_paint_glyph(cursor, glyph, colour);
         display_draw();
 
         /* sleep a while to show the ray's position */
-        napms(100);
+        display_delay(100);
         /* repaint the screen unless requested otherwise */
         if (!keep_ray) display_paint_screen(nlarn->p);
     }
-    while ((iter = iter->next));
 
     /* none of the trigger functions succeeded */
-    g_list_free(ray);
     return FALSE;
 }
 
-area *map_get_obstacles(map *m, position center, int radius, gboolean doors)
+void map_get_obstacles(map *m, position center, int radius, gboolean doors,
+                       area *obstacles)
 {
-    area *narea;
     position pos = pos_invalid;
     int x, y;
 
-    g_assert(m != NULL);
+    g_assert(m != NULL && obstacles != NULL && pos_valid(center));
 
-    if (!pos_valid(center))
-    {
-        return NULL;
-    }
-
-    narea = area_new(X(center) - radius, Y(center) - radius,
-                     radius * 2 + 1, radius * 2 + 1);
+    area_init(obstacles, X(center) - radius, Y(center) - radius,
+              radius * 2 + 1, radius * 2 + 1);
 
     Z(pos) = m->nlevel;
 
@@ -776,20 +773,18 @@ area *map_get_obstacles(map *m, position center, int radius, gboolean doors)
         {
             if (!pos_valid(pos))
             {
-                area_point_set(narea, x, y);
+                area_point_set(obstacles, x, y);
                 continue;
             }
             if (doors && map_sobject_at(m, pos) == LS_CLOSEDDOOR)
                 continue;
             else if (!map_pos_transparent(m, pos))
-                area_point_set(narea, x, y);
+                area_point_set(obstacles, x, y);
         }
     }
-
-    return narea;
 }
 
-void map_set_tiletype(map *m, area *ar, map_tile_t type, guint8 duration)
+void map_set_tiletype(map *m, const area *ar, map_tile_t type, guint8 duration)
 {
     position pos = pos_invalid;
     int x, y;
@@ -834,29 +829,32 @@ void map_set_tiletype(map *m, area *ar, map_tile_t type, guint8 duration)
     }
 }
 
-damage *map_tile_damage(map *m, position pos, gboolean flying)
+gboolean map_tile_damage(map *m, position pos, gboolean flying, damage *dam)
 {
-    g_assert (m != NULL && pos_valid(pos));
+    g_assert (m != NULL && dam != NULL && pos_valid(pos));
 
     switch (map_tiletype_at(m, pos))
     {
     case LT_CLOUD:
-        return damage_new(DAM_ACID, ATT_NONE, 3 + rand_0n(2), DAMO_MAP, NULL);
+        *dam = damage_new(DAM_ACID, ATT_NONE, 3 + rand_0n(2), DAMO_MAP, NULL);
+        return TRUE;
         break;
 
     case LT_FIRE:
-        return damage_new(DAM_FIRE, ATT_NONE, 5 + rand_0n(2), DAMO_MAP, NULL);
+        *dam = damage_new(DAM_FIRE, ATT_NONE, 5 + rand_0n(2), DAMO_MAP, NULL);
+        return TRUE;
         break;
 
     case LT_WATER:
         if (flying)
-            return NULL;
+            return FALSE;
 
-        return damage_new(DAM_WATER, ATT_NONE, 4 + rand_0n(2), DAMO_MAP, NULL);
+        *dam = damage_new(DAM_WATER, ATT_NONE, 4 + rand_0n(2), DAMO_MAP, NULL);
+        return TRUE;
         break;
 
     default:
-        return NULL;
+        return FALSE;
     }
 }
 
@@ -1033,6 +1031,8 @@ void map_timer(map *m)
 
     g_assert (m != NULL);
 
+    gint64 prof_start = profile_begin();
+
     Z(pos) = m->nlevel;
 
     for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
@@ -1086,6 +1086,8 @@ void map_timer(map *m)
             } /* if map_timer_at */
         } /* for X(pos) */
     } /* for Y(pos) */
+
+    profile_end(PP_MAP_TIMER, prof_start);
 }
 
 char map_get_door_glyph(map *m, position pos)
@@ -1719,9 +1721,9 @@ static gboolean map_load_from_file(map *m, const char *mazefile, guint which)
         {
             map_num = rand_1n(MAP_MAX_MAZE_NUM);
         }
-        while (map_used[map_num] && ++tries < 100);
+        while (nlarn->maze_used[map_num] && ++tries < 100);
 
-        map_used[map_num] = TRUE;
+        nlarn->maze_used[map_num] = TRUE;
     }
 
     /* determine number of line separating character(s) */
@@ -1982,8 +1984,9 @@ static int map_validate(map *m)
 {
     position pos = pos_invalid;
     int connected = TRUE;
-    area *floodmap = NULL;
-    area *obsmap = area_new(0, 0, MAP_MAX_X, MAP_MAX_Y);
+    area floodmap, obsmap;
+
+    area_init(&obsmap, 0, 0, MAP_MAX_X, MAP_MAX_Y);
 
     Z(pos) = m->nlevel;
 
@@ -1993,7 +1996,7 @@ static int map_validate(map *m)
             if (!map_pos_passable(m, pos)
                     && (map_sobject_at(m, pos) != LS_CLOSEDDOOR))
             {
-                area_point_set(obsmap, X(pos), Y(pos));
+                area_point_set(&obsmap, X(pos), Y(pos));
             }
 
     /* get position of entrance */
@@ -2015,7 +2018,7 @@ static int map_validate(map *m)
     }
 
     /* flood fill the maze starting at the entrance */
-    floodmap = area_flood(obsmap, X(pos), Y(pos));
+    area_flood(&floodmap, &obsmap, X(pos), Y(pos));
 
     /* compare flooded area with obstacle map */
     for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
@@ -2026,7 +2029,7 @@ static int map_validate(map *m)
             int cd = (map_sobject_at(m, pos) == LS_CLOSEDDOOR);
 
             /* point should be set on floodmap if it is passable */
-            if (area_point_get(floodmap, X(pos), Y(pos)) != (pp || cd))
+            if (area_point_get(&floodmap, X(pos), Y(pos)) != (pp || cd))
             {
                 connected = FALSE;
                 break;
@@ -2037,8 +2040,6 @@ static int map_validate(map *m)
             break;
     }
 
-    area_destroy(floodmap);
-
     return connected;
 }
 
@@ -28,6 +28,7 @@
 #include "monsters.h"
 #include "extdefs.h"
 #include "pathfinding.h"
+#include "profile.h"
 #include "random.h"
 
 DEFINE_ENUM(monster_flag, MONSTER_FLAG_ENUM)
@@ -71,8 +72,11 @@ struct _monster
     inventory *inv;
     item *eq_weapon;
     GPtrArray *effects;
+    effect_summary esummary; /* per-type summary of the effects above */
     guint number;        /* random value for some monsters */
     gpointer leader;    /* for pack monsters: ID of the leader */
+    struct _monster *mprev; /* previous monster on the same map */
+    struct _monster *mnext; /* next monster on the same map */
     guint32
         unknown: 1;      /* monster is unknown (mimic) */
 };
@@ -764,10 +768,13 @@ static position monster_move_flee(monster *m, struct player *p);
 static position monster_move_serve(monster *m, struct player *p);
 static position monster_move_civilian(monster *m, struct player *p);
 
-static gboolean monster_breath_hit(const GList *traj,
+static gboolean monster_breath_hit(const position_span *traj, guint idx,
         const damage_originator *damo,
         gpointer data1, gpointer data2);
 
+static void monster_map_link(monster *m, map *mp);
+static void monster_map_unlink(monster *m, map *mp);
+
 monster *monster_new(monster_t type, position pos, gpointer leader)
 {
     g_assert(type < MT_MAX && pos_valid(pos));
@@ -793,6 +800,7 @@ monster *monster_new(monster_t type, position pos, gpointer leader)
 
     /* make room for monster */
     nmonster = g_malloc0(sizeof(monster));
+    profile_alloc(PM_MONSTERS, sizeof(monster));
 
     nmonster->type = type;
 
@@ -942,6 +950,9 @@ monster *monster_new(monster_t type, position pos, gpointer leader)
     /* link monster to tile */
     map_set_monster_at(game_map(nlarn, Z(pos)), pos, nmonster);
 
+    /* add the monster to the map's monster list */
+    monster_map_link(nmonster, game_map(nlarn, Z(pos)));
+
     /* add some members to the pack if we created a pack monster */
     if (monster_flags(nmonster, PACK) && !leader)
     {
@@ -959,9 +970,6 @@ monster *monster_new(monster_t type, position pos, gpointer leader)
         }
     }
 
-    /* increment monster count */
-    game_map(nlarn, Z(pos))->mcount++;
-
     return nmonster;
 }
 
@@ -1010,7 +1018,10 @@ monster *monster_new_by_level(position pos)
             minstep--;
 
         if (minstep < 0)
+        {
+            minstep = -1;
             monster_id_min = MT_GIANT_BAT;
+        }
         else
             monster_id_min = mlevel[minstep] + 1;
 
@@ -1021,14 +1032,32 @@ monster *monster_new_by_level(position pos)
 
         monster_id_max = mlevel[maxstep];
 
-        do
+        rand_alias **sampler = &nlarn->monster_samplers[minstep + 1][maxstep];
+
+        if (*sampler == NULL)
         {
-            monster_id = rand_m_n(monster_id_min, monster_id_max);
+            /* Each type is chosen as often as if a type of the range was
+               picked at random and rerolled with the type's reroll chance
+               or if it had been genocided. */
+            guint32 weights[MT_MAX];
+            guint count = monster_id_max - monster_id_min;
+
+            for (guint idx = 0; idx < count; idx++)
+            {
+                monster_t type = monster_id_min + idx;
+
+                weights[idx] = nlarn->monster_genocided[type]
+                               ? 0 : max(0, 100 - monster_type_reroll_chance(type));
+            }
+
+            *sampler = rand_alias_new(weights, count);
         }
-        while ((monster_id < 0)
-                || (monster_id >= MT_MAX)
-                || nlarn->monster_genocided[monster_id]
-                || chance(monster_type_reroll_chance(monster_id)));
+
+        /* every suitable monster has been genocided */
+        if (*sampler == NULL)
+            return NULL;
+
+        monster_id = monster_id_min + rand_alias_draw(*sampler);
     }
 
     return monster_new(monster_id, pos, NULL);
@@ -1055,14 +1084,15 @@ void monster_destroy(monster *m)
     /* unregister monster */
     game_monster_unregister(nlarn, m->oid);
 
-    /* decrement monster count */
-    game_map(nlarn, Z(m->pos))->mcount--;
+    /* remove the monster from its map's monster list */
+    monster_map_unlink(m, game_map(nlarn, Z(m->pos)));
 
     /* free monster's FOV if existing */
     if (m->fv)
         fov_free(m->fv);
 
     g_free(m);
+    profile_free(PM_MONSTERS, sizeof(monster));
 }
 
 void monster_serialize(gpointer oid, monster *m, cJSON *root)
@@ -1115,6 +1145,7 @@ void monster_deserialize(cJSON *mser, game *g)
     cJSON *obj;
     guint oid;
     monster *m = g_malloc0(sizeof(monster));
+    profile_alloc(PM_MONSTERS, sizeof(monster));
 
     m->type = cJSON_GetObjectItem(mser, "type")->valueint;
     oid = cJSON_GetObjectItem(mser, "oid")->valueint;
@@ -1158,6 +1189,11 @@ void monster_deserialize(cJSON *mser, game *g)
     else
         m->effects = g_ptr_array_new();
 
+    effect_summary_rebuild(&m->esummary, m->effects);
+
+    for (guint idx = 0; idx < m->effects->len; idx++)
+        effect_schedule(game_effect_get(g, g_ptr_array_index(m->effects, idx)), m->oid);
+
     /* add monster to game */
     g_hash_table_insert(g->monsters, m->oid, m);
 
@@ -1165,8 +1201,8 @@ void monster_deserialize(cJSON *mser, game *g)
     if (oid > g->monster_max_id)
         g->monster_max_id = oid;
 
-    /* increment the count of monsters of the map the monster is on */
-    game_map(g, Z(m->pos))->mcount++;
+    /* add the monster to the monster list of the map it is on */
+    monster_map_link(m, game_map(g, Z(m->pos)));
 }
 
 int monster_hp_max(monster *m)
@@ -1246,6 +1282,13 @@ int monster_pos_set(monster *m, map *mp, position target)
         /* remove current reference to monster from tile */
         map_set_monster_at(monster_map(m), m->pos, NULL);
 
+        /* move the monster to the new map's monster list */
+        if (Z(m->pos) != Z(target))
+        {
+            monster_map_unlink(m, monster_map(m));
+            monster_map_link(m, mp);
+        }
+
         /* set new position */
         m->pos = target;
 
@@ -1359,7 +1402,7 @@ const char* monster_type_plural_name(monster_t mt, const int count)
         if (monster_data[mt].plural_name == NULL)
         {
             /* need a static buffer to return to calling functions */
-            static char buf[61] = { 0 };
+            static THREAD_LOCAL char buf[61] = { 0 };
             g_snprintf(buf, 60, "%ss", monster_type_name(mt));
             return buf;
         }
@@ -1548,10 +1591,11 @@ void monster_level_enter(monster *m, struct map *l)
     }
 }
 
-void monster_move(gpointer *oid __attribute__((unused)), monster *m, game *g)
+gboolean monster_turn_begin(monster *m, game *g)
 {
-    /* monster's new position */
-    position m_npos;
+    if (monster_hp(m) < 1)
+        /* Monster is already dead. */
+        return FALSE;
 
     /* expire summoned monsters */
     if (monster_action(m) == MA_SERVE
@@ -1563,43 +1607,28 @@ void monster_move(gpointer *oid __attribute__((unused)), monster *m, game *g)
         {
             /* expired */
             monster_die(m, g->p);
-            return;
+            return FALSE;
         }
     }
 
-    if (monster_hp(m) < 1)
-        /* Monster is already dead. */
-        return;
-
-    position mpos = monster_pos(m);
-
     /* modify effects */
     monster_effects_expire(m);
 
     /* regenerate / inflict poison upon monster. */
     if (!monster_regenerate(m, g->gtime, g->difficulty))
         /* the monster died */
-        return;
+        return FALSE;
 
     /* damage caused by map effects */
-    damage *dam = map_tile_damage(monster_map(m), monster_pos(m),
-                                  monster_flags(m, FLY)
-                                  || monster_effect(m, ET_LEVITATION));
+    damage dam;
 
     /* deal damage caused by floor effects */
-    if ((dam != NULL) && !(m = monster_damage_take(m, dam)))
+    if (map_tile_damage(monster_map(m), monster_pos(m),
+                        monster_flags(m, FLY) || monster_effect(m, ET_LEVITATION),
+                        &dam)
+            && !(m = monster_damage_take(m, dam)))
         /* the monster died */
-        return;
-
-    /* move the monster only if it is on the same map as the player or
-       an adjacent map */
-    gboolean map_adjacent = (Z(mpos) == Z(g->p->pos)
-                             || (Z(mpos) == Z(g->p->pos) - 1)
-                             || (Z(mpos) == Z(g->p->pos) + 1)
-                             || (Z(mpos) == MAP_CMAX && Z(g->p->pos) == 0)
-                            );
-    if (!map_adjacent)
-        return;
+        return FALSE;
 
     /* Update the monster's knowledge of player's position.
        Not for civilians or servants: the first don't care,
@@ -1618,187 +1647,227 @@ void monster_move(gpointer *oid __attribute__((unused)), monster *m, game *g)
     /* add the monster's speed to the monster's movement points */
     m->movement += monster_speed(m);
 
-    /* let the monster make a move as long it has movement points left */
-    while (m->movement >= NORMAL)
+    return TRUE;
+}
+
+int monster_wakeup(monster *m)
+{
+    int speed, missing;
+
+    g_assert(m != NULL);
+
+    /* the monster has no movement points left for this turn */
+    if (m->movement < NORMAL)
+        return -1;
+
+    speed = monster_speed(m);
+
+    /* movement points missing at the start of the turn to make this move */
+    missing = NORMAL - (m->movement - speed);
+
+    if (speed <= 0 || missing <= 0)
+        return 0;
+
+    return min(missing * NORMAL / speed, NORMAL);
+}
+
+gboolean monster_act(monster *m, game *g)
+{
+    /* monster's new position */
+    position m_npos;
+
+    /* the monster has been killed earlier in this turn */
+    if (monster_hp(m) < 1)
+        return FALSE;
+
+    /* reduce the monster's movement points */
+    m->movement -= NORMAL;
+
+    /* update monsters action */
+    if (monster_update_action(m, MA_NONE) && monster_in_sight(m))
     {
-        /* reduce the monster's movement points */
-        m->movement -= NORMAL;
+        /* the monster has chosen a new action and the player
+           can see the new action, so let's describe it */
 
-        /* update monsters action */
-        if (monster_update_action(m, MA_NONE) && monster_in_sight(m))
+        if (m->action == MA_ATTACK && monster_sound(m))
         {
-            /* the monster has chosen a new action and the player
-               can see the new action, so let's describe it */
-
-            if (m->action == MA_ATTACK && monster_sound(m))
-            {
-                const char *sound = monster_sound(m);
-                log_add_entry(g->log, "The %s %s%ss!",
-                              monster_name(m), sound,
-                              sound[strlen(sound) - 1] == 's' ? "e": "");
-            }
-            else if (m->action == MA_FLEE)
-            {
-                log_add_entry(g->log, "The %s turns to flee!",
-                        monster_get_name(m));
-            }
+            const char *sound = monster_sound(m);
+            log_add_entry(g->log, "The %s %s%ss!",
+                          monster_name(m), sound,
+                          sound[strlen(sound) - 1] == 's' ? "e": "");
+        }
+        else if (m->action == MA_FLEE)
+        {
+            log_add_entry(g->log, "The %s turns to flee!",
+                    monster_get_name(m));
         }
+    }
 
-        /* let the monster have a look at the items at it's current position
-           if it chose to pick up something, the turn is over */
-        if (monster_items_pickup(m))
-            return;
+    /* let the monster have a look at the items at it's current position
+       if it chose to pick up something, the turn is over */
+    if (monster_items_pickup(m))
+        return FALSE;
 
-        /* determine monster's next move */
-        m_npos = monster_pos(m);
+    /* determine monster's next move */
+    m_npos = monster_pos(m);
 
-        switch (m->action)
-        {
-        case MA_FLEE:
-            m_npos = monster_move_flee(m, g->p);
-            break;
+    switch (m->action)
+    {
+    case MA_FLEE:
+        m_npos = monster_move_flee(m, g->p);
+        break;
 
-        case MA_REMAIN:
-            /* Sgt. Stan Still - do nothing */
-            break;
+    case MA_REMAIN:
+        /* Sgt. Stan Still - do nothing */
+        break;
 
-        case MA_WANDER:
-            m_npos = monster_move_wander(m, g->p);
-            break;
+    case MA_WANDER:
+        m_npos = monster_move_wander(m, g->p);
+        break;
 
-        case MA_ATTACK:
-            /* monster tries a ranged attack */
-            if (monster_player_visible(m)
-                    && monster_player_ranged_attack(m, g->p))
-                return;
+    case MA_ATTACK:
+        /* monster tries a ranged attack */
+        if (monster_player_visible(m)
+                && monster_player_ranged_attack(m, g->p))
+            return FALSE;
 
-            m_npos = monster_move_attack(m, g->p);
-            break;
+        m_npos = monster_move_attack(m, g->p);
+        break;
 
-        case MA_CONFUSION:
-            m_npos = monster_move_confused(m, g->p);
-            break;
+    case MA_CONFUSION:
+        m_npos = monster_move_confused(m, g->p);
+        break;
 
-        case MA_SERVE:
-            m_npos = monster_move_serve(m, g->p);
-            break;
+    case MA_SERVE:
+        m_npos = monster_move_serve(m, g->p);
+        break;
 
-        case MA_CIVILIAN:
-            m_npos = monster_move_civilian(m, g->p);
-            break;
+    case MA_CIVILIAN:
+        m_npos = monster_move_civilian(m, g->p);
+        break;
 
-        case MA_NONE:
-            /* possibly a bug */
-            break;
-        }
+    case MA_NONE:
+        /* possibly a bug */
+        break;
+    }
 
-        /* ******** if new position has been found - move the monster ********* */
-        if (!pos_identical(m_npos, monster_pos(m)))
-        {
-            /* get the monster's current map */
-            map *mmap = monster_map(m);
+    /* ******** if new position has been found - move the monster ********* */
+    if (!pos_identical(m_npos, monster_pos(m)))
+    {
+        /* get the monster's current map */
+        map *mmap = monster_map(m);
 
-            /* get stationary object at the monster's target position */
-            sobject_t target_st = map_sobject_at(mmap, m_npos);
+        /* get stationary object at the monster's target position */
+        sobject_t target_st = map_sobject_at(mmap, m_npos);
 
-            /* vampires won't step onto mirrors */
-            if ((m->type == MT_VAMPIRE) && (target_st == LS_MIRROR))
-            {
-                /* No movement - FIXME: should try to move around it */
-            }
+        /* vampires won't step onto mirrors */
+        if ((m->type == MT_VAMPIRE) && (target_st == LS_MIRROR))
+        {
+            /* No movement - FIXME: should try to move around it */
+        }
 
-            else if (pos_identical(g->p->pos, m_npos))
-            {
-                /* The monster bumps into the player who is invisible to the
-                   monster. Thus the monster gains knowledge over the player's
-                   current position. */
-                monster_update_player_pos(m, g->p->pos);
+        else if (pos_identical(g->p->pos, m_npos))
+        {
+            /* The monster bumps into the player who is invisible to the
+               monster. Thus the monster gains knowledge over the player's
+               current position. */
+            monster_update_player_pos(m, g->p->pos);
 
-                log_add_entry(g->log, "The %s bumps into you.", monster_get_name(m));
-            }
+            log_add_entry(g->log, "The %s bumps into you.", monster_get_name(m));
+        }
 
-            /* check for door */
-            else if ((target_st == LS_CLOSEDDOOR) && monster_flags(m, HANDS))
+        /* check for door */
+        else if ((target_st == LS_CLOSEDDOOR) && monster_flags(m, HANDS))
+        {
+            /* dim-witted or confused monster are unable to open doors */
+            if (monster_int(m) < 4 || monster_effect_get(m, ET_CONFUSION))
             {
-                /* dim-witted or confused monster are unable to open doors */
-                if (monster_int(m) < 4 || monster_effect_get(m, ET_CONFUSION))
+                /* notify the player if the door is visible */
+                if (monster_in_sight(m))
                 {
-                    /* notify the player if the door is visible */
-                    if (monster_in_sight(m))
-                    {
-                        log_add_entry(g->log, "The %s bumps into the door.",
-                                      monster_get_name(m));
-                    }
+                    log_add_entry(g->log, "The %s bumps into the door.",
+                                  monster_get_name(m));
                 }
-                else
-                {
-                    /* the monster is capable of opening the door */
-                    map_sobject_set(mmap, m_npos, LS_OPENDOOR);
+            }
+            else
+            {
+                /* the monster is capable of opening the door */
+                map_sobject_set(mmap, m_npos, LS_OPENDOOR);
 
-                    /* notify the player if the door is visible */
-                    if (monster_in_sight(m))
-                    {
-                        log_add_entry(g->log, "The %s opens the door.",
-                                      monster_get_name(m));
-                    }
+                /* notify the player if the door is visible */
+                if (monster_in_sight(m))
+                {
+                    log_add_entry(g->log, "The %s opens the door.",
+                                  monster_get_name(m));
                 }
             }
+        }
 
-            /* set the monsters new position */
+        /* set the monsters new position */
+        else
+        {
+            /* check if the new position is valid for this monster */
+            if (map_pos_validate(mmap, m_npos, monster_map_element(m), FALSE))
+            {
+                /* the new position is valid -> reposition the monster */
+                monster_pos_set(m, mmap, m_npos);
+            }
             else
             {
-                /* check if the new position is valid for this monster */
-                if (map_pos_validate(mmap, m_npos, monster_map_element(m), FALSE))
+                /* the new position is invalid */
+                map_tile_t nle = map_tiletype_at(mmap, m_npos);
+
+                switch (nle)
                 {
-                    /* the new position is valid -> reposition the monster */
-                    monster_pos_set(m, mmap, m_npos);
+                    case LT_TREE:
+                    case LT_WALL:
+                        if (monster_in_sight(m))
+                        {
+                            log_add_entry(g->log, "The %s bumps into %s.",
+                                    monster_get_name(m), mt_get_desc(nle));
+                        }
+                        break;
+
+                    case LT_LAVA:
+                    case LT_DEEPWATER:
+                        if (monster_in_sight(m)) {
+                            log_add_entry(g->log, "The %s sinks into %s.",
+                                    monster_get_name(m), mt_get_desc(nle));
+                        }
+                        monster_die(m, g->p);
+                        break;
+
+                    default:
+                        /* just do not move.. */
+                        break;
                 }
-                else
-                {
-                    /* the new position is invalid */
-                    map_tile_t nle = map_tiletype_at(mmap, m_npos);
+            }
 
-                    switch (nle)
-                    {
-                        case LT_TREE:
-                        case LT_WALL:
-                            if (monster_in_sight(m))
-                            {
-                                log_add_entry(g->log, "The %s bumps into %s.",
-                                        monster_get_name(m), mt_get_desc(nle));
-                            }
-                            break;
-
-                        case LT_LAVA:
-                        case LT_DEEPWATER:
-                            if (monster_in_sight(m)) {
-                                log_add_entry(g->log, "The %s sinks into %s.",
-                                        monster_get_name(m), mt_get_desc(nle));
-                            }
-                            monster_die(m, g->p);
-                            break;
-
-                        default:
-                            /* just do not move.. */
-                            break;
-                    }
-                }
+            /* check for traps */
+            if (map_trap_at(mmap, monster_pos(m)))
+            {
+                if (!monster_trap_trigger(m))
+                    return FALSE; /* trap killed the monster */
+            }
 
-                /* check for traps */
-                if (map_trap_at(mmap, monster_pos(m)))
-                {
-                    if (!monster_trap_trigger(m))
-                        return; /* trap killed the monster */
-                }
+        } /* end new position */
+    } /* end monster repositioning */
 
-            } /* end new position */
-        } /* end monster repositioning */
-    } /* while movement >= NORMAL */
+    return TRUE;
+}
 
+void monster_turn_end(monster *m)
+{
     /* increment count of turns since when player was last seen */
     if (m->lastseen) m->lastseen++;
 }
 
+monster *monster_map_next(monster *m)
+{
+    g_assert (m != NULL);
+    return m->mnext;
+}
+
 void monster_polymorph(monster *m)
 {
     g_assert (m != NULL);
@@ -1810,11 +1879,19 @@ void monster_polymorph(monster *m)
     }
 
     const map_element_t old_elem = monster_map_element(m);
-    do
+
+    if (nlarn->polymorph_sampler == NULL)
     {
-        m->type = rand_1n(MT_DEMON_PRINCE);
+        guint32 weights[MT_DEMON_PRINCE] = { 0 };
+
+        for (monster_t type = 1; type < MT_DEMON_PRINCE; type++)
+            weights[type] = !monster_is_genocided(type);
+
+        nlarn->polymorph_sampler = rand_alias_new(weights, MT_DEMON_PRINCE);
     }
-    while (monster_is_genocided(m->type));
+
+    if (nlarn->polymorph_sampler != NULL)
+        m->type = rand_alias_draw(nlarn->polymorph_sampler);
 
     /* if the new monster can't survive in this terrain, kill it */
     const map_element_t new_elem = monster_map_element(m);
@@ -1836,7 +1913,7 @@ void monster_polymorph(monster *m)
         {
             /* briefly display the new monster before it dies */
             display_paint_screen(nlarn->p);
-            g_usleep(250000);
+            display_delay(250);
 
             switch (old_elem)
             {
@@ -1985,12 +2062,12 @@ static int monster_breath_attack(monster *m, player *p, attack att)
     g_assert(att.type == ATT_BREATH);
 
     /* generate damage */
-    damage *dam = damage_new(att.damage, att.type, att.base + game_difficulty(nlarn),
-                             DAMO_MONSTER, m);
+    damage dam = damage_new(att.damage, att.type, att.base + game_difficulty(nlarn),
+                            DAMO_MONSTER, m);
 
     /* the attack might have a random amount */
     if (att.rand > 0)
-        dam->amount += rand_0n(att.rand);
+        dam.amount += rand_0n(att.rand);
 
     if (monster_in_sight(m))
     {
@@ -2004,15 +2081,11 @@ static int monster_breath_attack(monster *m, player *p, attack att)
     }
 
     /* handle the breath */
-    map_trajectory(m->pos, p->pos, &(dam->dam_origin),
-                   monster_breath_hit, dam, NULL, TRUE,
+    map_trajectory(m->pos, p->pos, &(dam.dam_origin),
+                   monster_breath_hit, &dam, NULL, TRUE,
                    monster_breath_data[att.damage].glyph,
                    monster_breath_data[att.damage].colour, TRUE);
 
-    /* the damage is copied in monster_breath_hit(), thus destroy the
-       original damage here */
-    damage_free(dam);
-
     return FALSE;
 }
 
@@ -2071,67 +2144,64 @@ void monster_player_attack(monster *m, player *p)
     }
 
     /* generate damage */
-    damage *dam = damage_new(att.damage, att.type,
+    damage dam = damage_new(att.damage, att.type,
                         modified_attack_amount(att.base, att.damage),
                         DAMO_MONSTER, m);
 
     /* deal with random damage (spirit naga) */
-    if (dam->type == DAM_RANDOM)
-        dam->type = rand_1n(DAM_MAX);
+    if (dam.type == DAM_RANDOM)
+        dam.type = rand_1n(DAM_MAX);
 
-    if (dam->type == DAM_DEC_RND)
-        dam->type = rand_m_n(DAM_DEC_CON, DAM_DEC_RND);
+    if (dam.type == DAM_DEC_RND)
+        dam.type = rand_m_n(DAM_DEC_CON, DAM_DEC_RND);
 
     /* set damage for weapon attacks */
     if (att.type == ATT_WEAPON)
     {
         /* make monster size affect weapon damage */
         /* FIXME: handle the vorpal blade */
-        dam->amount  = (m->eq_weapon != NULL) ? weapon_damage(m->eq_weapon) : 1
+        dam.amount  = (m->eq_weapon != NULL) ? weapon_damage(m->eq_weapon) : 1
                         + (int)rand_0n(game_difficulty(nlarn) + 2)
                         + monster_level(m)
                         + 2 * ((monster_size(m) - MEDIUM)) / 25;
     }
-    else if (dam->type == DAM_PHYSICAL)
+    else if (dam.type == DAM_PHYSICAL)
     {
         /* increase damage with difficulty */
-        dam->amount = att.base
+        dam.amount = att.base
                       + monster_level(m)
                       + rand_0n(game_difficulty(nlarn) + 2);
     }
 
     /* add variable damage */
-    if (att.rand) dam->amount += rand_1n(att.rand);
+    if (att.rand) dam.amount += rand_1n(att.rand);
 
     /* half damage if player is protected against spirits */
     if (player_effect(p, ET_SPIRIT_PROTECTION) && monster_flags(m, SPIRIT))
     {
-        if (dam->type == DAM_PHYSICAL)
+        if (dam.type == DAM_PHYSICAL)
         {
             /* halve physical damage */
-            dam->amount >>= 1;
+            dam.amount >>= 1;
         }
         else
         {
             /* FIXME: give log message */
-            damage_free(dam);
-
             return;
         }
     }
 
     /* handle some damage types here */
-    switch (dam->type)
+    switch (dam.type)
     {
     case DAM_STEAL_GOLD:
     case DAM_STEAL_ITEM:
-        if (monster_player_rob(m, p, (dam->type == DAM_STEAL_GOLD) ? IT_GOLD : IT_ALL))
+        if (monster_player_rob(m, p, (dam.type == DAM_STEAL_GOLD) ? IT_GOLD : IT_ALL))
         {
             /* teleport away */
             monster_pos_set(m, mmap, map_find_space(mmap, LE_MONSTER, FALSE));
         }
 
-        damage_free(dam);
         break;
 
     case DAM_RUST:
@@ -2140,13 +2210,11 @@ void monster_player_attack(monster *m, player *p)
 
         monster_item_rust(m, p);
         p->attacked = TRUE;
-        damage_free(dam);
         break;
 
     case DAM_REM_ENCH:
         monster_item_disenchant(m, p);
         p->attacked = TRUE;
-        damage_free(dam);
         break;
 
     default:
@@ -2189,7 +2257,7 @@ int monster_player_ranged_attack(monster *m, player *p)
         }
         else
         {
-            damage *dam = damage_new(att.damage, att.type,
+            damage dam = damage_new(att.damage, att.type,
                     att.base + game_difficulty(nlarn), DAMO_MONSTER, m);
 
             player_damage_take(p, dam, PD_MONSTER, m->type);
@@ -2202,25 +2270,25 @@ int monster_player_ranged_attack(monster *m, player *p)
     return monster_breath_attack(m, p, att);
 }
 
-monster *monster_damage_take(monster *m, damage *dam)
+monster *monster_damage_take(monster *m, damage dam)
 {
     struct player *p = NULL;
 
-    g_assert(m != NULL && dam != NULL);
+    g_assert(m != NULL);
 
-    if (dam->dam_origin.ot == DAMO_PLAYER)
-        p = (player *)dam->dam_origin.originator;
+    if (dam.dam_origin.ot == DAMO_PLAYER)
+        p = (player *)dam.dam_origin.originator;
 
     if (game_wizardmode(nlarn) && fov_get(nlarn->p->fv, m->pos))
-        log_add_entry(nlarn->log, damage_to_str(dam));
+        log_add_entry(nlarn->log, damage_to_str(&dam));
 
     int hp_orig = m->hp;
 
-    switch (dam->type)
+    switch (dam.type)
     {
     case DAM_PHYSICAL:
-        dam->amount -= monster_ac(m);
-        if (dam->amount < 1 && monster_in_sight(m))
+        dam.amount -= monster_ac(m);
+        if (dam.amount < 1 && monster_in_sight(m))
         {
             log_add_entry(nlarn->log, "The %s isn't hurt.",
                     monster_get_name(m));
@@ -2230,11 +2298,11 @@ monster *monster_damage_take(monster *m, damage *dam)
     case DAM_MAGICAL:
         if (monster_flags(m, RES_MAGIC))
         {
-            dam->amount /= monster_level(m);
+            dam.amount /= monster_level(m);
             if (monster_in_sight(m))
             {
                 log_add_entry(nlarn->log, "The %s %sresists the magic.",
-                        monster_get_name(m), dam->amount > 0 ? "partly " : "");
+                        monster_get_name(m), dam.amount > 0 ? "partly " : "");
             }
         }
         break;
@@ -2246,13 +2314,13 @@ monster *monster_damage_take(monster *m, damage *dam)
              * The monster's fire resistance reduces the damage taken
              * by 10% per monster level
              */
-            dam->amount -= (guint)(((float)dam->amount / 100) *
+            dam.amount -= (guint)(((float)dam.amount / 100) *
                  /* prevent uint wrap around for monsters with level > 10 */
                  (min(monster_level(m), 10) * 10));
             if (monster_in_sight(m))
             {
                 log_add_entry(nlarn->log, "The %s %sresists the flames.",
-                        monster_get_name(m), dam->amount > 0 ? "partly " : "");
+                        monster_get_name(m), dam.amount > 0 ? "partly " : "");
             }
         }
         break;
@@ -2260,7 +2328,7 @@ monster *monster_damage_take(monster *m, damage *dam)
     case DAM_COLD:
         if (monster_flags(m, RES_COLD))
         {
-            dam->amount = 0;
+            dam.amount = 0;
             if (monster_in_sight(m))
             {
                 log_add_entry(nlarn->log, "The %s loves the cold!",
@@ -2271,13 +2339,13 @@ monster *monster_damage_take(monster *m, damage *dam)
 
     case DAM_WATER:
         if (monster_flags(m, SWIM))
-            dam->amount = 0;
+            dam.amount = 0;
         break;
 
     case DAM_ELECTRICITY:
         if (monster_flags(m, RES_ELEC))
         {
-            dam->amount = 0;
+            dam.amount = 0;
             if (monster_in_sight(m))
             {
                 log_add_entry(nlarn->log, "The %s is not affected!",
@@ -2287,7 +2355,7 @@ monster *monster_damage_take(monster *m, damage *dam)
         /* double damage for flying monsters */
         else if (monster_flags(m, FLY) || monster_effect(m, ET_LEVITATION))
         {
-            dam->amount *= 2;
+            dam.amount *= 2;
             // special message?
         }
         break;
@@ -2298,7 +2366,7 @@ monster *monster_damage_take(monster *m, damage *dam)
 
     /* subtract damage from HP;
      * prevent adding to HP after resistance has lowered damage amount */
-    m->hp -= max(0, dam->amount);
+    m->hp -= max(0, dam.amount);
 
     if (game_wizardmode(nlarn) && fov_get(nlarn->p->fv, m->pos))
         log_add_entry(nlarn->log, "[applied: %d]", hp_orig - m->hp);
@@ -2383,8 +2451,6 @@ monster *monster_damage_take(monster *m, damage *dam)
         m = NULL;
     }
 
-    g_free(dam);
-
     return m;
 }
 
@@ -2640,6 +2706,19 @@ void monster_genocide(monster_t monster_id)
     g_assert(monster_id < MT_MAX);
 
     nlarn->monster_genocided[monster_id] = TRUE;
+
+    /* the samplers of monster types have to be rebuilt without it */
+    for (int minstep = 0; minstep < MAP_MAX; minstep++)
+    {
+        for (int maxstep = 0; maxstep < MAP_MAX; maxstep++)
+        {
+            rand_alias_destroy(nlarn->monster_samplers[minstep][maxstep]);
+            nlarn->monster_samplers[minstep][maxstep] = NULL;
+        }
+    }
+
+    rand_alias_destroy(nlarn->polymorph_sampler);
+    nlarn->polymorph_sampler = NULL;
     mlist = g_hash_table_get_values(nlarn->monsters);
 
     /* purge genocided monsters */
@@ -2727,8 +2806,13 @@ effect *monster_effect_add(monster *m, effect *e)
     }
     else if (e)
     {
+        effect_t type = e->type;
+
         /* multi-turn effects */
         e = effect_add(m->effects, e);
+        effect_summary_update(&m->esummary, m->effects, type);
+
+        if (e) effect_schedule(e, m->oid);
 
         /* if it's confusion, set the monster's "AI" accordingly */
         if (e && e->type == ET_CONFUSION) {
@@ -2780,6 +2864,8 @@ int monster_effect_del(monster *m, effect *e)
 
     if ((result = effect_del(m->effects, e)))
     {
+        effect_summary_update(&m->esummary, m->effects, e->type);
+
         /* if confusion or charm is finished, set the AI back to the default */
         if (e->type == ET_CONFUSION || e->type == ET_CHARM_MONSTER) {
             monster_update_action(m, monster_default_ai(m));
@@ -2806,46 +2892,39 @@ int monster_effect_del(monster *m, effect *e)
 effect *monster_effect_get(monster *m , effect_t type)
 {
     g_assert(m != NULL && type < ET_MAX);
+
+    /* avoid searching the effect array if there is no such effect */
+    if (!effect_summary_active(&m->esummary, type))
+        return NULL;
+
     return effect_get(m->effects, type);
 }
 
 int monster_effect(monster *m, effect_t type)
 {
     g_assert(m != NULL && type < ET_MAX);
-    return effect_query(m->effects, type);
+    return effect_summary_amount(&m->esummary, type);
 }
 
 void monster_effects_expire(monster *m)
 {
-    guint idx = 0;
+    effect *e;
 
     g_assert(m != NULL);
 
-    while (idx < m->effects->len)
-    {
-        gpointer effect_id = g_ptr_array_index(m->effects, idx);;
-        effect *e = game_effect_get(nlarn, effect_id);
+    /* other effects time out by the game time, see effects_expire() */
+    if (!(e = monster_effect_get(m, ET_TRAPPED)))
+        return;
 
-        if (e->type == ET_TRAPPED)
-        {
-            /* if the monster is incapable of movement don't decrease
-               trapped counter */
-            if (monster_effect(m, ET_HOLD_MONSTER)
-                    || monster_effect(m, ET_SLEEP))
-            {
-                idx++;
-            }
-        }
+    /* if the monster is incapable of movement don't decrease
+       trapped counter */
+    if (monster_effect(m, ET_HOLD_MONSTER) || monster_effect(m, ET_SLEEP))
+        return;
 
-        if (effect_expire(e) == -1)
-        {
-            /* effect has expired */
-            monster_effect_del(m, e);
-        }
-        else
-        {
-            idx++;
-        }
+    if (effect_expire(e) == -1)
+    {
+        /* effect has expired */
+        monster_effect_del(m, e);
     }
 }
 
@@ -3054,9 +3133,9 @@ static gboolean monster_player_rob(monster *m, struct player *p, item_t item_typ
         {
             /* grab gold at player's position */
             inventory **floor = map_ilist_at(monster_map(m), p->pos);
-            if (inv_length_filtered(*floor, item_filter_gold))
+            if (inv_length_type(*floor, IT_GOLD))
             {
-                it = inv_get_filtered(*floor, 0, item_filter_gold);
+                it = inv_get_type(*floor, 0, IT_GOLD);
                 inv_del_element(floor, it);
 
                 if (monster_in_sight(m))
@@ -3140,10 +3219,11 @@ static gboolean monster_player_rob(monster *m, struct player *p, item_t item_typ
 
 static char *monster_get_fortune(const char *fortune_file)
 {
-    /* array of pointers to fortunes */
+    /* array of pointers to fortunes, shared by all games */
     static GPtrArray *fortunes = NULL;
+    static gsize fortunes_read = 0;
 
-    if (!fortunes)
+    if (g_once_init_enter(&fortunes_read))
     {
         /* read in the fortunes */
         char buffer[80];
@@ -3151,28 +3231,33 @@ static char *monster_get_fortune(const char *fortune_file)
 
         /* open the file */
         fortune_fd = fopen(fortune_file, "r");
-        if (fortune_fd == NULL)
+        if (fortune_fd != NULL)
         {
-            /* can't find file */
-            return "Help me! I can't find the fortune file!";
-        }
+            fortunes = g_ptr_array_new();
 
-        fortunes = g_ptr_array_new();
+            /* read in the entire fortune file */
+            while((fgets(buffer, 79, fortune_fd)))
+            {
+                /* replace EOL with \0 */
+                size_t len = (size_t)(strchr(buffer, '\n') - (char *)&buffer);
+                buffer[len] = '\0';
+
+                /* keep the line */
+                char *tmp = g_malloc((len + 1) * sizeof(char));
+                memcpy(tmp, &buffer, (len + 1));
+                g_ptr_array_add(fortunes, tmp);
+            }
 
-        /* read in the entire fortune file */
-        while((fgets(buffer, 79, fortune_fd)))
-        {
-            /* replace EOL with \0 */
-            size_t len = (size_t)(strchr(buffer, '\n') - (char *)&buffer);
-            buffer[len] = '\0';
-
-            /* keep the line */
-            char *tmp = g_malloc((len + 1) * sizeof(char));
-            memcpy(tmp, &buffer, (len + 1));
-            g_ptr_array_add(fortunes, tmp);
+            fclose(fortune_fd);
         }
 
-        fclose(fortune_fd);
+        g_once_init_leave(&fortunes_read, 1);
+    }
+
+    if (fortunes == NULL)
+    {
+        /* can't find file */
+        return "Help me! I can't find the fortune file!";
     }
 
     return g_ptr_array_index(fortunes, rand_0n(fortunes->len));
@@ -3525,8 +3610,42 @@ inline int monster_type_reroll_chance(monster_t type)
     return monster_data[type].reroll_chance;
 }
 
+static void monster_map_link(monster *m, map *mp)
+{
+    g_assert(m != NULL && mp != NULL);
+
+    /* append the monster to keep the list in order of arrival */
+    m->mprev = mp->mlast;
+    m->mnext = NULL;
+
+    if (mp->mlast != NULL)
+        mp->mlast->mnext = m;
+    else
+        mp->mfirst = m;
+
+    mp->mlast = m;
+    mp->mcount++;
+}
+
+static void monster_map_unlink(monster *m, map *mp)
+{
+    g_assert(m != NULL && mp != NULL);
+
+    if (m->mprev != NULL)
+        m->mprev->mnext = m->mnext;
+    else
+        mp->mfirst = m->mnext;
+
+    if (m->mnext != NULL)
+        m->mnext->mprev = m->mprev;
+    else
+        mp->mlast = m->mprev;
+
+    m->mprev = m->mnext = NULL;
+    mp->mcount--;
+}
 
-static gboolean monster_breath_hit(const GList *traj,
+static gboolean monster_breath_hit(const position_span *traj, guint idx,
                                    const damage_originator *damo __attribute__((unused)),
                                    gpointer data1,
                                    gpointer data2 __attribute__((unused)))
@@ -3535,7 +3654,7 @@ static gboolean monster_breath_hit(const GList *traj,
     damage *dam = (damage *)data1;
     item_erosion_type iet;
     gboolean terminated = FALSE;
-    position pos; pos_val(pos) = GPOINTER_TO_UINT(traj->data);
+    position pos = traj->pos[idx];
     map *mp = game_map(nlarn, Z(pos));
 
     /* determine if items should be eroded */
@@ -3570,7 +3689,7 @@ static gboolean monster_breath_hit(const GList *traj,
         if (iet && monster_inv(m))
             inv_erode(monster_inv(m), iet, FALSE, NULL);
 
-        monster_damage_take(m, damage_copy(dam));
+        monster_damage_take(m, *dam);
 
         /* the breath will sweep over small monsters */
         if (monster_size(m) >= LARGE)
@@ -3593,7 +3712,7 @@ static gboolean monster_breath_hit(const GList *traj,
             /* TODO: evasion!!! */
             log_add_entry(nlarn->log, "The %s hits you!",
                           monster_breath_data[dam->type].desc);
-            player_damage_take(nlarn->p, damage_copy(dam), PD_MONSTER,
+            player_damage_take(nlarn->p, *dam, PD_MONSTER,
                                monster_type(dam->dam_origin.originator));
 
             /* erode the player's inventory */
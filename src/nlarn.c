@@ -42,19 +42,14 @@
 #include "game.h"
 #include "nlarn.h"
 #include "pathfinding.h"
+#include "profile.h"
+#include "replay.h"
 #include "player.h"
 #include "scoreboard.h"
 #include "sobjects.h"
 #include "traps.h"
 #include "extdefs.h"
 
-/* see https://stackoverflow.com/q/36764885/1519878 */
-#define _STR(x) #x
-#define STR(x) _STR(x)
-
-/* version string */
-const char *nlarn_version = STR(VERSION_MAJOR) "." STR(VERSION_MINOR) "." STR(VERSION_PATCH) GITREV;
-
 /* empty scoreboard description */
 const char *room_for_improvement = "\n...room for improvement...\n";
 
@@ -63,22 +58,13 @@ static const char *default_lib_dir = "/usr/share/nlarn";
 #if ((defined (__unix) || defined (__unix__)) && defined (SETGID))
 static const char *default_var_dir = "/var/games/nlarn";
 #endif
-static const char *mesgfile = "nlarn.msg";
-static const char *helpfile = "nlarn.hlp";
-static const char *mazefile = "maze";
-static const char *fortunes = "fortune";
 static const char *highscores = "highscores";
 static const char *config_file = "nlarn.ini";
 static const char *save_file = "nlarn.sav";
 
-/* global game object */
-game *nlarn = NULL;
-
 /* the game settings */
 static struct game_config config = {};
 
-/* death jump buffer - used to return to the main loop when the player has died */
-jmp_buf nlarn_death_jump;
 
 static gboolean adjacent_corridor(position pos, char mv);
 
@@ -171,10 +157,7 @@ static void nlarn_init(int argc, char *argv[])
         }
     }
 
-    nlarn_mesgfile = g_build_filename(nlarn_libdir, mesgfile, NULL);
-    nlarn_helpfile = g_build_filename(nlarn_libdir, helpfile, NULL);
-    nlarn_mazefile = g_build_filename(nlarn_libdir, mazefile, NULL);
-    nlarn_fortunes = g_build_filename(nlarn_libdir, fortunes, NULL);
+    game_set_libdir(nlarn_libdir);
 
 #if ((defined (__unix) || defined (__unix__)) && defined (SETGID))
     /* highscore file handling for SETGID builds */
@@ -272,6 +255,30 @@ static void nlarn_init(int argc, char *argv[])
     /* try to load settings from the configuration file */
     parse_ini_file(nlarn_inifile, &config);
 
+    /* record or play back the game */
+    if (config.replay && !replay_play_start(config.replay, &config, config.replay_turn))
+    {
+        g_printerr("Cannot play back the recording %s.\n", config.replay);
+        exit(EXIT_FAILURE);
+    }
+    else if (config.record && !config.replay && !replay_record_start(config.record, &config))
+    {
+        g_printerr("Cannot record the game to %s.\n", config.record);
+        exit(EXIT_FAILURE);
+    }
+
+    if (config.profile_out)
+        profile_write_on_exit(config.profile_out);
+
+    if (config.mem_report)
+        profile_memory_write_on_exit(config.mem_report);
+
+    if (config.trace && !profile_trace_start(config.trace))
+    {
+        g_printerr("Cannot write the trace to %s.\n", config.trace);
+        exit(EXIT_FAILURE);
+    }
+
 #ifdef SDLPDCURSES
     /* If a font size was defined, export it to the environment
      * before initialising PDCurses. */
@@ -284,7 +291,7 @@ static void nlarn_init(int argc, char *argv[])
 #endif
     /* initialise the display - must not happen before this point
        otherwise displaying the command line help fails */
-    display_init();
+    display_init(config.headless ? DB_NULL : DB_CURSES);
 
     /* call display_shutdown when terminating the game */
     atexit(display_shutdown);
@@ -837,6 +844,7 @@ static void mainloop()
         case KEY_RESIZE: /* SDL window size event */
 #endif
             clear();
+            display_map_invalidate();
             display_draw();
             break;
 
@@ -968,6 +976,21 @@ static void mainloop()
             if (game_wizardmode(nlarn))
                 calc_fighting_stats(nlarn->p);
             break;
+
+        case 5: /* ^E */
+            if (game_wizardmode(nlarn))
+            {
+                char *times = profile_report();
+                char *memory = profile_memory_report();
+                char *report = g_strconcat(times, "\n", memory, NULL);
+
+                display_show_message("Resources used", report, 0);
+
+                g_free(times);
+                g_free(memory);
+                g_free(report);
+            }
+            break;
         }
 
         gboolean no_move = (moves_count == 0);
@@ -1109,14 +1132,22 @@ int main(int argc, char *argv[])
     */
     player_cod cod = setjmp(nlarn_death_jump);
 
+    /* a recording ends with its game */
+    if (cod != PD_NONE)
+        replay_stop();
+
     /* clear the screen to wipe remains from the previous game */
     clear();
+    display_map_invalidate();
 
     /* can be broken by quitting in the game, or with q or ESC in main menu */
     while (cod != PD_QUIT)
     {
-        /* initialise the game */
-        game_init(&config);
+        /* initialise the game - recorded games are always new */
+        if (replay_active())
+            game_create(&config, replay_seed());
+        else
+            game_init(&config);
 
         /* present main menu - */
         if (FALSE == main_menu()) {
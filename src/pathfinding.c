@@ -19,6 +19,7 @@
 #include "extdefs.h"
 #include "pathfinding.h"
 #include "player.h"
+#include "profile.h"
 
 static path *path_new(position start, position goal);
 static path_element *path_element_new(position pos);
@@ -43,6 +44,7 @@ path *path_find(map *m, position start, position goal, map_element_t element)
     if (Z(start) != Z(goal))
         return NULL;
 
+    gint64 prof_start = profile_begin();
     path *pt = path_new(start, goal);
 
     /* add start to open list */
@@ -72,6 +74,7 @@ path *path_find(map *m, position start, position goal, map_element_t element)
             }
             while (curr != NULL);
 
+            profile_end(PP_PATH_FIND, prof_start);
             return pt;
         }
 
@@ -119,6 +122,7 @@ path *path_find(map *m, position start, position goal, map_element_t element)
 
     /* could not find a path */
     path_destroy(pt);
+    profile_end(PP_PATH_FIND, prof_start);
 
     return NULL;
 }
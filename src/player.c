@@ -29,6 +29,7 @@
 #include "game.h"
 #include "extdefs.h"
 #include "player.h"
+#include "profile.h"
 #include "random.h"
 #include "scoreboard.h"
 #include "sobjects.h"
@@ -117,8 +118,8 @@ static inline void player_item_pickup_ask(player *p, inventory **inv, item *it)
 
 static void player_sobject_memorize(player *p, sobject_t sobject, position pos);
 static int player_sobjects_sort(gconstpointer a, gconstpointer b);
-static cJSON *player_memory_serialize(player *p, position pos);
-static void player_memory_deserialize(player *p, position pos, cJSON *mser);
+static cJSON *player_memory_serialize(player *p, int nlevel);
+static void player_memory_deserialize(player *p, int nlevel, cJSON *mser);
 static char *player_equipment_list(player *p);
 static char *player_create_obituary(player *p, score_t *score, GList *scores);
 static void player_memorial_file_save(player *p, const char *text);
@@ -334,6 +335,15 @@ void player_destroy(player *p)
     /* clean the FOV */
     fov_free(p->fv);
 
+    for (int nlevel = 0; nlevel < MAP_MAX; nlevel++)
+    {
+        if (p->memory[nlevel] == NULL)
+            continue;
+
+        g_free(p->memory[nlevel]);
+        profile_free(PM_PLAYER_MEMORY, MAP_SIZE * sizeof(player_tile_memory));
+    }
+
     g_free(p);
 }
 
@@ -464,21 +474,11 @@ cJSON *player_serialize(player *p)
         cJSON_AddNumberToObject(pser, "ptarget", GPOINTER_TO_UINT(p->ptarget));
     }
 
-    position pos = pos_invalid;
-
     /* store players' memory of the map */
     cJSON_AddItemToObject(pser, "memory", obj = cJSON_CreateArray());
 
-    for (Z(pos) = 0; Z(pos) < MAP_MAX; Z(pos)++)
-    {
-        cJSON *mm = cJSON_CreateArray();
-
-        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
-            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-                cJSON_AddItemToArray(mm, player_memory_serialize(p, pos));
-
-        cJSON_AddItemToArray(obj, mm);
-    }
+    for (int nlevel = 0; nlevel < MAP_MAX; nlevel++)
+        cJSON_AddItemToArray(obj, player_memory_serialize(p, nlevel));
 
     /* store remembered stationary objects */
     if (p->sobjmem != NULL)
@@ -598,6 +598,11 @@ player *player_deserialize(cJSON *pser)
     else
         p->effects = g_ptr_array_new();
 
+    effect_summary_rebuild(&p->esummary, p->effects);
+
+    for (guint idx = 0; idx < p->effects->len; idx++)
+        effect_schedule(game_effect_get(nlarn, g_ptr_array_index(p->effects, idx)), NULL);
+
     /* equipped items */
     obj = cJSON_GetObjectItem(pser, "eq_amulet");
     if (obj != NULL) p->eq_amulet = game_item_get(nlarn, GUINT_TO_POINTER(obj->valueint));
@@ -673,21 +678,13 @@ player *player_deserialize(cJSON *pser)
     }
 
     /* restore players' memory of the map */
-    position pos = pos_invalid;
     obj = cJSON_GetObjectItem(pser, "memory");
+    elem = obj->child;
 
-    for (Z(pos) = 0; Z(pos) < MAP_MAX; Z(pos)++)
+    for (int nlevel = 0; nlevel < MAP_MAX && elem != NULL; nlevel++)
     {
-        elem = cJSON_GetArrayItem(obj, Z(pos));
-
-        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
-        {
-            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-            {
-                cJSON *tile = cJSON_GetArrayItem(elem, X(pos) + (MAP_MAX_X * Y(pos)));
-                player_memory_deserialize(p, pos, tile);
-            }
-        }
+        player_memory_deserialize(p, nlevel, elem);
+        elem = elem->next;
     }
 
     /* remembered stationary objects */
@@ -759,7 +756,6 @@ gboolean player_make_move(player *p, int turns, gboolean interruptible, const ch
     int frequency; /* number of turns between occasions */
     int regen = 0; /* amount of regeneration */
     effect *e; /* temporary var for effect */
-    guint idx = 0;
     g_autofree char *description = NULL, *popup_desc = NULL;
 
     g_assert(p != NULL);
@@ -831,39 +827,6 @@ gboolean player_make_move(player *p, int turns, gboolean interruptible, const ch
             /* move the rest of the world */
             game_spin_the_wheel(nlarn);
 
-            /* expire temporary effects */
-            idx = 0; // reset idx for proper expiration during multiturn events
-            while (idx < p->effects->len)
-            {
-                gpointer effect_id = g_ptr_array_index(p->effects, idx);
-                e = game_effect_get(nlarn, effect_id);
-
-                /* trapped counter only reduces on movement */
-                if (e->type != ET_TRAPPED && effect_expire(e) == -1)
-                {
-                    /* effect has expired */
-                    player_effect_del(p, e);
-                }
-                else
-                {
-                    /* give a warning if critical effects are about to time out */
-                    if (e->turns == 5)
-                    {
-                        gboolean interrupt_actions = TRUE;
-                        if (e->type == ET_WALL_WALK)
-                            log_add_entry(nlarn->log, "`lightred`Your attunement to the walls is fading!`end`");
-                        else if (e->type == ET_LEVITATION)
-                            log_add_entry(nlarn->log, "`lightred`You are starting to drift towards the ground!`end`");
-                        else
-                            interrupt_actions = FALSE;
-
-                        if (interrupt_actions)
-                            p->attacked = TRUE;
-                    }
-                    idx++;
-                }
-            }
-
             /* handle regeneration */
             if (p->regen_counter == 0)
             {
@@ -895,7 +858,7 @@ gboolean player_make_move(player *p, int turns, gboolean interruptible, const ch
                 int amount = 1 + (e->amount / 15);
                 if ((game_turn(nlarn) - e->start) % freq == 0)
                 {
-                    damage *dam = damage_new(DAM_POISON, ATT_NONE,
+                    damage dam = damage_new(DAM_POISON, ATT_NONE,
                             game_difficulty(nlarn) + amount, DAMO_NONE, NULL);
 
                     player_damage_take(p, dam, PD_EFFECT, e->type);
@@ -936,11 +899,16 @@ gboolean player_make_move(player *p, int turns, gboolean interruptible, const ch
             if (turns > 1)
             {
                 /* repaint the screen and do a little pause when the action
-                   continues, for longer episodes a shorter time. */
-                if (!interruptible || p->attacked)
+                   continues, for longer episodes a shorter time. Turns of
+                   longer episodes during which no monster has been seen
+                   moving are neither shown nor delayed; the game world
+                   still advances turn by turn. */
+                gboolean idle = (turns > 10) && (nlarn->visible_moves == 0);
+
+                if ((!interruptible && !idle) || p->attacked)
                 {
                     display_paint_screen(p);
-                    napms((turns > 10) ? 1 : 50);
+                    display_delay((turns > 10) ? 1 : 50);
                 }
 
                 /* offer to abort the action if the player is under attack */
@@ -1012,6 +980,8 @@ void player_die(player *p, player_cod cause_type, int cause)
         if (ef->amount > 1)
         {
             ef->amount--;
+            effect_summary_update(&p->esummary, p->effects, ef->type);
+            player_modifiers_invalidate(p);
         }
         else
         {
@@ -1138,17 +1108,18 @@ void player_die(player *p, player_cod cause_type, int cause)
 
     /* We really died! */
 
-    /* do not show scores when in wizard mode */
-    if (!game_wizardmode(nlarn))
+    /* do not show scores when in wizard mode or when there is
+       nobody to show them to, e.g. when played by an agent */
+    if (!game_wizardmode(nlarn) && display_available())
     {
         /* redraw screen to make sure player can see the cause of his death */
         display_paint_screen(p);
 
         /* sleep a second */
-        g_usleep(1000000);
+        display_delay(1000);
 
         /* flush keyboard input buffer */
-        flushinp();
+        display_flush_input();
 
         score_t *score = score_new(nlarn, cause_type, cause);
         GList *scores = score_add(nlarn, score);
@@ -1505,7 +1476,7 @@ int player_attack(player *p, monster *m)
 
     if (chance(5) || chance(weapon_calc_to_hit(p, m, p->eq_weapon, NULL)))
     {
-        damage *dam;
+        damage dam;
         effect *e;
 
         /* placed a hit */
@@ -1964,20 +1935,20 @@ int player_hp_lose(player *p, int count, player_cod cause_type, int cause)
     return p->hp;
 }
 
-void player_damage_take(player *p, damage *dam, player_cod cause_type, int cause)
+void player_damage_take(player *p, damage dam, player_cod cause_type, int cause)
 {
     effect *e = NULL;
     int hp_orig;
     guint effects_count;
 
-    g_assert(p != NULL && dam != NULL);
+    g_assert(p != NULL);
 
     if (game_wizardmode(nlarn))
-        log_add_entry(nlarn->log, damage_to_str(dam));
+        log_add_entry(nlarn->log, damage_to_str(&dam));
 
-    if (dam->dam_origin.ot == DAMO_MONSTER)
+    if (dam.dam_origin.ot == DAMO_MONSTER)
     {
-        monster *m = (monster *)dam->dam_origin.originator;
+        monster *m = (monster *)dam.dam_origin.originator;
 
         /* amulet of power cancels demon attacks */
         if (monster_flags(m, DEMON) && chance(75)
@@ -1990,7 +1961,7 @@ void player_damage_take(player *p, damage *dam, player_cod cause_type, int cause
         }
     }
 
-    if (dam->attack == ATT_GAZE && player_effect_get(p, ET_BLINDNESS))
+    if (dam.attack == ATT_GAZE && player_effect_get(p, ET_BLINDNESS))
     {
         /* it is impossible to see a staring monster when blinded */
         return;
@@ -2001,12 +1972,8 @@ void player_damage_take(player *p, damage *dam, player_cod cause_type, int cause
     hp_orig = p->hp;
     effects_count = p->effects->len;
 
-    /* keep damage type and amount for subsequent usage, but free the damage
-       object itself - when the player dies, the object will be leaked */
-    damage_t damage_type = dam->type;
-    gint damage_amount = dam->amount;
-    g_free(dam);
-
+    damage_t damage_type = dam.type;
+    gint damage_amount = dam.amount;
 
     /* check resistances */
     switch (damage_type)
@@ -2513,6 +2480,7 @@ effect *player_effect_add(player *p, effect *e)
     else
     {
         int str_orig = player_get_str(p);
+        effect_t type = e->type;
 
         e = effect_add(p->effects, e);
 
@@ -2520,6 +2488,8 @@ effect *player_effect_add(player *p, effect *e)
            actually has a value */
         if (e)
         {
+            effect_schedule(e, NULL);
+
             if (effect_get_amount(e) > 0 && effect_get_msg_start(e))
                 log_add_entry(nlarn->log, "%s", effect_get_msg_start(e));
             else if (effect_get_amount(e) < 0 && effect_get_msg_stop(e))
@@ -2536,6 +2506,9 @@ effect *player_effect_add(player *p, effect *e)
             }
         }
 
+        effect_summary_update(&p->esummary, p->effects, type);
+        player_modifiers_invalidate(p);
+
         if (str_orig != player_get_str(p))
         {
             /* strength has been modified -> recalc burdened status */
@@ -2571,6 +2544,9 @@ int player_effect_del(player *p, effect *e)
 
     if ((result = effect_del(p->effects, e)))
     {
+        effect_summary_update(&p->esummary, p->effects, e->type);
+        player_modifiers_invalidate(p);
+
         if (effect_get_amount(e) > 0 && effect_get_msg_stop(e))
             log_add_entry(nlarn->log, "%s", effect_get_msg_stop(e));
         else if (effect_get_amount(e) < 0 && effect_get_msg_start(e))
@@ -2608,13 +2584,18 @@ void player_effects_del(player *p, GPtrArray *effects)
 effect *player_effect_get(player *p, effect_t et)
 {
     g_assert(p != NULL && et > ET_NONE && et < ET_MAX);
+
+    /* avoid searching the effect array if there is no such effect */
+    if (!effect_summary_active(&p->esummary, et))
+        return NULL;
+
     return effect_get(p->effects, et);
 }
 
 int player_effect(player *p, effect_t et)
 {
     g_assert(p != NULL && et > ET_NONE && et < ET_MAX);
-    return effect_query(p->effects, et);
+    return effect_summary_amount(&p->esummary, et);
 }
 
 char **player_effect_text(player *p)
@@ -2720,7 +2701,7 @@ int player_inv_display(player *p)
 
 static char *player_print_weight(float weight)
 {
-    static char buf[21] = "";
+    static THREAD_LOCAL char buf[21] = "";
 
     const char *unit = "g";
     if (weight > 1000)
@@ -2736,7 +2717,7 @@ static char *player_print_weight(float weight)
 
 char *player_can_carry(player *p)
 {
-    static char buf[21] = "";
+    static THREAD_LOCAL char buf[21] = "";
     g_snprintf(buf, 20, "%s",
                player_print_weight(2000 * 1.3 * (float)player_get_str(p)));
     return buf;
@@ -2744,7 +2725,7 @@ char *player_can_carry(player *p)
 
 char *player_inv_weight(player *p)
 {
-    static char buf[21] = "";
+    static THREAD_LOCAL char buf[21] = "";
     g_snprintf(buf, 20, "%s",
                player_print_weight((float)inv_weight(p->inventory)));
     return buf;
@@ -2972,6 +2953,7 @@ void player_item_equip(player *p, inventory **inv __attribute__((unused)), item
 
             /* put the piece of armour in the equipment slot */
             *islot = it;
+            player_modifiers_invalidate(p);
         }
         break;
 
@@ -3193,6 +3175,7 @@ void player_item_unequip(player *p,
                 {
                     player_effects_del(p, (*aslot)->effects);
                     *aslot = NULL;
+                    player_modifiers_invalidate(p);
                 }
             }
             else
@@ -3781,6 +3764,7 @@ void player_item_use(player *p, inventory **inv __attribute__((unused)), item *i
         if (it->count > 1)
         {
             it->count--;
+            inv_items_changed();
         }
         else
         {
@@ -4037,33 +4021,49 @@ void player_drop(player *p)
     }
 }
 
-guint player_get_ac(player *p)
+void player_modifiers_update(player *p)
 {
-    int ac = 0;
     g_assert(p != NULL);
 
-    if (p->eq_boots != NULL)
-        ac += armour_ac(p->eq_boots);
+    item *armour[] =
+    {
+        p->eq_boots, p->eq_cloak, p->eq_gloves,
+        p->eq_helmet, p->eq_shield, p->eq_suit
+    };
+
+    /* all attributes are affected alike by these */
+    const int common = player_effect(p, ET_HEROISM)
+                       - player_effect(p, ET_DIZZINESS);
+
+    p->mods.ac = player_effect(p, ET_PROTECTION)
+                 + player_effect(p, ET_INVULNERABILITY);
+
+    for (guint idx = 0; idx < G_N_ELEMENTS(armour); idx++)
+    {
+        if (armour[idx] != NULL)
+            p->mods.ac += armour_ac(armour[idx]);
+    }
 
-    if (p->eq_cloak != NULL)
-        ac += armour_ac(p->eq_cloak);
+    p->mods.strength = common + player_effect(p, ET_INC_STR)
+                       - player_effect(p, ET_DEC_STR);
 
-    if (p->eq_gloves != NULL)
-        ac += armour_ac(p->eq_gloves);
+    p->mods.intelligence = common + player_effect(p, ET_INC_INT)
+                           - player_effect(p, ET_DEC_INT);
 
-    if (p->eq_helmet != NULL)
-        ac += armour_ac(p->eq_helmet);
+    p->mods.wisdom = common + player_effect(p, ET_INC_WIS)
+                     - player_effect(p, ET_DEC_WIS);
 
-    if (p->eq_shield != NULL)
-        ac += armour_ac(p->eq_shield);
+    p->mods.constitution = common + player_effect(p, ET_INC_CON)
+                           - player_effect(p, ET_DEC_CON);
 
-    if (p->eq_suit != NULL)
-        ac += armour_ac(p->eq_suit);
+    p->mods.dexterity = common + player_effect(p, ET_INC_DEX)
+                        - player_effect(p, ET_DEC_DEX);
 
-    ac += player_effect(p, ET_PROTECTION);
-    ac += player_effect(p, ET_INVULNERABILITY);
+    p->mods.speed = player_effect(p, ET_SPEED)
+                    - player_effect(p, ET_SLOWNESS)
+                    - player_effect(p, ET_BURDENED);
 
-    return ac;
+    p->mods.valid = TRUE;
 }
 
 int player_get_hp_max(player *p)
@@ -4078,65 +4078,6 @@ int player_get_mp_max(player *p)
     return p->mp_max;
 }
 
-int player_get_str(player *p)
-{
-    g_assert(p != NULL);
-    return p->strength
-           + player_effect(p, ET_INC_STR)
-           - player_effect(p, ET_DEC_STR)
-           + player_effect(p, ET_HEROISM)
-           - player_effect(p, ET_DIZZINESS);
-}
-
-int player_get_int(player *p)
-{
-    g_assert(p != NULL);
-    return p->intelligence
-           + player_effect(p, ET_INC_INT)
-           - player_effect(p, ET_DEC_INT)
-           + player_effect(p, ET_HEROISM)
-           - player_effect(p, ET_DIZZINESS);
-}
-
-int player_get_wis(player *p)
-{
-    g_assert(p != NULL);
-    return p->wisdom
-           + player_effect(p, ET_INC_WIS)
-           - player_effect(p, ET_DEC_WIS)
-           + player_effect(p, ET_HEROISM)
-           - player_effect(p, ET_DIZZINESS);
-}
-
-int player_get_con(player *p)
-{
-    g_assert(p != NULL);
-    return p->constitution
-           + player_effect(p, ET_INC_CON)
-           - player_effect(p, ET_DEC_CON)
-           + player_effect(p, ET_HEROISM)
-           - player_effect(p, ET_DIZZINESS);
-}
-
-int player_get_dex(player *p)
-{
-    g_assert(p != NULL);
-    return p->dexterity
-           + player_effect(p, ET_INC_DEX)
-           - player_effect(p, ET_DEC_DEX)
-           + player_effect(p, ET_HEROISM)
-           - player_effect(p, ET_DIZZINESS);
-}
-
-int player_get_speed(player *p)
-{
-    g_assert(p != NULL);
-    return p->speed
-           + player_effect(p, ET_SPEED)
-           - player_effect(p, ET_SLOWNESS)
-           - player_effect(p, ET_BURDENED);
-}
-
 guint player_get_gold(player *p)
 {
     guint gold = 0;
@@ -4144,9 +4085,9 @@ guint player_get_gold(player *p)
     g_assert(p != NULL);
 
     /* gold stacks, thus there can only be one item in the inventory */
-    if (inv_length_filtered(p->inventory, item_filter_gold))
+    if (inv_length_type(p->inventory, IT_GOLD))
     {
-        item *i = inv_get_filtered(p->inventory, 0, item_filter_gold);
+        item *i = inv_get_type(p->inventory, 0, IT_GOLD);
         gold += i->count;
     }
 
@@ -4172,9 +4113,9 @@ void player_remove_gold(player *p, guint amount)
     g_assert(p != NULL);
 
     /* gold stacks, thus there can only be one item in the inventory */
-    if (inv_length_filtered(p->inventory, item_filter_gold))
+    if (inv_length_type(p->inventory, IT_GOLD))
     {
-        item *i = inv_get_filtered(p->inventory, 0, item_filter_gold);
+        item *i = inv_get_type(p->inventory, 0, IT_GOLD);
 
         if (amount >= i->count)
         {
@@ -4184,6 +4125,7 @@ void player_remove_gold(player *p, guint amount)
         else
         {
             i->count -= amount;
+            inv_items_changed();
             goto done;
         }
     }
@@ -4206,6 +4148,7 @@ void player_remove_gold(player *p, guint amount)
             else
             {
                 i->count -= amount;
+                inv_items_changed();
                 goto done;
             }
         }
@@ -4344,6 +4287,8 @@ void player_update_fov(player *p)
 
     int range = (Z(p->pos) == 0 ? 15 : 6);
 
+    gint64 prof_start = profile_begin();
+
     /* calculate range */
     if (player_effect(nlarn->p, ET_BLINDNESS))
         radius = 0;
@@ -4366,18 +4311,19 @@ void player_update_fov(player *p)
         /* reset FOV manually */
         fov_reset(p->fv);
 
-        area *enlight = area_new_circle(p->pos,
+        area enlight;
+        area_init_circle(&enlight, p->pos,
                 player_effect(p, ET_ENLIGHTENMENT), FALSE);
 
         /* set visible field according to returned area */
-        for (int y = 0; y < enlight->size_y; y++)
+        for (int y = 0; y < enlight.size_y; y++)
         {
-            for (int x = 0; x < enlight->size_x; x++)
+            for (int x = 0; x < enlight.size_x; x++)
             {
-                X(pos) = x + enlight->start_x;
-                Y(pos) = y + enlight->start_y;
+                X(pos) = x + enlight.start_x;
+                Y(pos) = y + enlight.start_y;
 
-                if (pos_valid(pos) && area_point_get(enlight, x, y))
+                if (pos_valid(pos) && area_point_get(&enlight, x, y))
                 {
                     /* The position if enlightened.
                        Now determine if the position has a direct visible connection
@@ -4391,8 +4337,6 @@ void player_update_fov(player *p)
                 }
             }
         }
-
-        area_destroy(enlight);
     }
     else
     {
@@ -4438,7 +4382,7 @@ void player_update_fov(player *p)
                     if (it != NULL)
                     {
                         player_memory_of(p,pos).item = it->type;
-                        player_memory_of(p,pos).item_colour = item_colour(it);
+                        player_memory_of(p,pos).item_colour = display_colour_index(item_colour(it));
                     }
                 }
                 else if (inv_length(*inv) > 0)
@@ -4446,15 +4390,15 @@ void player_update_fov(player *p)
                     item *it;
 
                     /* memorize the most interesting item on the tile */
-                    if (inv_length_filtered(*inv, item_filter_gems) > 0)
+                    if (inv_length_type(*inv, IT_GEM) > 0)
                     {
                         /* there's a gem in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gems);
+                        it = inv_get_type(*inv, 0, IT_GEM);
                     }
-                    else if (inv_length_filtered(*inv, item_filter_gold) > 0)
+                    else if (inv_length_type(*inv, IT_GOLD) > 0)
                     {
                         /* there is gold in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gold);
+                        it = inv_get_type(*inv, 0, IT_GOLD);
                     }
                     else
                     {
@@ -4463,7 +4407,7 @@ void player_update_fov(player *p)
                     }
 
                     player_memory_of(p,pos).item = it->type;
-                    player_memory_of(p,pos).item_colour = item_colour(it);
+                    player_memory_of(p,pos).item_colour = display_colour_index(item_colour(it));
                 }
                 else
                 {
@@ -4474,6 +4418,8 @@ void player_update_fov(player *p)
             }
         }
     }
+
+    profile_end(PP_PLAYER_FOV, prof_start);
 }
 
 static guint player_item_pickup(player *p, inventory **inv, item *it, gboolean ask)
@@ -4686,57 +4632,69 @@ static int player_sobjects_sort(gconstpointer a, gconstpointer b)
         return 1;
 }
 
-static cJSON *player_memory_serialize(player *p, position pos)
+player_tile_memory *player_memory_new(player *p, int nlevel)
 {
-    cJSON *mser;
+    g_assert(p != NULL && nlevel >= 0 && nlevel < MAP_MAX);
+    g_assert(p->memory[nlevel] == NULL);
 
-    mser = cJSON_CreateObject();
-    if (player_memory_of(p, pos).type > LT_NONE)
-        cJSON_AddNumberToObject(mser, "type",
-                                player_memory_of(p, pos).type);
+    p->memory[nlevel] = g_malloc0(MAP_SIZE * sizeof(player_tile_memory));
+    profile_alloc(PM_PLAYER_MEMORY, MAP_SIZE * sizeof(player_tile_memory));
 
-    if (player_memory_of(p, pos).sobject > LS_NONE)
-        cJSON_AddNumberToObject(mser, "sobject",
-                                player_memory_of(p, pos).sobject);
+    return p->memory[nlevel];
+}
 
-    if (player_memory_of(p, pos).item > IT_NONE)
-        cJSON_AddNumberToObject(mser, "item",
-                                player_memory_of(p, pos).item);
+/* the memory of a map is stored as four bytes per position in base64;
+   maps that have never been visited are stored as null */
+G_STATIC_ASSERT(sizeof(player_tile_memory) == 4);
+G_STATIC_ASSERT(LT_MAX <= 16 && IT_MAX <= 16 && LS_MAX <= 64 && TT_MAX <= 16);
 
-    if (player_memory_of(p, pos).item_colour > 0)
-        cJSON_AddNumberToObject(mser, "item_colour",
-                                player_memory_of(p, pos).item_colour);
+static cJSON *player_memory_serialize(player *p, int nlevel)
+{
+    const player_tile_memory *mem = p->memory[nlevel];
+    guchar buf[MAP_SIZE * 4];
 
-    if (player_memory_of(p, pos).trap > TT_NONE)
-        cJSON_AddNumberToObject(mser, "trap",
-                                player_memory_of(p, pos).trap);
+    if (mem == NULL)
+        return cJSON_CreateNull();
+
+    for (int idx = 0; idx < MAP_SIZE; idx++)
+    {
+        buf[idx * 4]     = mem[idx].type | (mem[idx].item << 4);
+        buf[idx * 4 + 1] = mem[idx].sobject;
+        buf[idx * 4 + 2] = mem[idx].item_colour;
+        buf[idx * 4 + 3] = mem[idx].trap;
+    }
+
+    gchar *text = g_base64_encode(buf, sizeof(buf));
+    cJSON *mser = cJSON_CreateString(text);
+    g_free(text);
 
     return mser;
 }
 
-static void player_memory_deserialize(player *p, position pos, cJSON *mser)
+static void player_memory_deserialize(player *p, int nlevel, cJSON *mser)
 {
-    cJSON *obj;
+    gsize len;
 
-    obj = cJSON_GetObjectItem(mser, "type");
-    if (obj != NULL)
-        player_memory_of(p, pos).type = obj->valueint;
+    if (!cJSON_IsString(mser))
+        return;
 
-    obj = cJSON_GetObjectItem(mser, "sobject");
-    if (obj != NULL)
-        player_memory_of(p, pos).sobject = obj->valueint;
+    guchar *buf = g_base64_decode(mser->valuestring, &len);
 
-    obj = cJSON_GetObjectItem(mser, "item");
-    if (obj != NULL)
-        player_memory_of(p, pos).item = obj->valueint;
+    if (len == MAP_SIZE * 4)
+    {
+        player_tile_memory *mem = player_memory_new(p, nlevel);
 
-    obj = cJSON_GetObjectItem(mser, "item_colour");
-    if (obj != NULL)
-        player_memory_of(p, pos).item_colour = obj->valueint;
+        for (int idx = 0; idx < MAP_SIZE; idx++)
+        {
+            mem[idx].type        = buf[idx * 4] & 0x0f;
+            mem[idx].item        = buf[idx * 4] >> 4;
+            mem[idx].sobject     = buf[idx * 4 + 1];
+            mem[idx].item_colour = buf[idx * 4 + 2];
+            mem[idx].trap        = buf[idx * 4 + 3];
+        }
+    }
 
-    obj = cJSON_GetObjectItem(mser, "trap");
-    if (obj != NULL)
-        player_memory_of(p, pos).trap = obj->valueint;
+    g_free(buf);
 }
 
 void calc_fighting_stats(player *p)
@@ -5179,12 +5137,12 @@ static char *player_create_obituary(player *p, score_t *score, GList *scores)
          pos < log_length(nlarn->log); pos++)
     {
         message_log_entry *entry = log_get_entry(nlarn->log, pos);
-        g_string_append_printf(text, "%s\n", entry->message);
+        g_string_append_printf(text, "%s\n", log_entry_text(nlarn->log, entry));
     }
     /* print uncommitted messages */
-    if (nlarn->log->buffer->len > 0)
+    if (log_buffer(nlarn->log) != NULL)
     {
-        g_string_append_printf(text, "%s\n", nlarn->log->buffer->str);
+        g_string_append_printf(text, "%s\n", log_buffer(nlarn->log));
     }
 
     return (g_string_free(text, FALSE));
@@ -18,6 +18,7 @@
 
 #include <glib.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cJSON.h"
 #include "display.h"
@@ -28,7 +29,30 @@
 #define POS_MAX_XY (1<<10)
 #define POS_MAX_Z  (1<<6)
 
-static void area_flood_worker(area *flood, area *obstacles, int x, int y);
+/* the circles drawn by area_init_circle() for every radius up to
+   AREA_MAX_RADIUS; every row is a bit mask with bit (dx + radius) set for
+   each point of the row. Larger circles are calculated when needed. */
+typedef enum _area_circle_type
+{
+    ACT_RING,        /* the hollow circle */
+    ACT_DISC,        /* the filled circle */
+    ACT_INTERIOR,    /* the points enclosed by the hollow circle */
+    ACT_MAX
+} area_circle_type;
+
+static guint64 area_circles[ACT_MAX][AREA_MAX_RADIUS + 1][2 * AREA_MAX_RADIUS + 1];
+
+/* the bits of the last word of a row that lie inside the map */
+#define AREA_LAST_WORD_MASK \
+    (G_MAXUINT64 >> (64 * AREA_WORDS - MAP_MAX_X))
+
+static void area_circles_init();
+static void area_circle_put(guint64 rows[MAP_MAX_Y][AREA_WORDS], position center,
+                            int radius, area_circle_type type);
+static void area_row_put(guint64 *row, guint64 mask, int offset);
+static void area_box_mask(const area *a, guint64 rows[MAP_MAX_Y][AREA_WORDS]);
+static void area_spread(area *flood, guint64 allowed[MAP_MAX_Y][AREA_WORDS],
+                        int x, int y);
 
 const position pos_invalid = { { POS_MAX_XY, POS_MAX_XY, POS_MAX_Z } };
 
@@ -209,26 +233,191 @@ int pos_in_rect(position pos, rectangle rect)
         return FALSE;
 }
 
-area *area_new(int start_x, int start_y, int size_x, int size_y)
+void area_init(area *a, int start_x, int start_y, int size_x, int size_y)
 {
-    area *a = g_malloc0(sizeof(area));
+    g_assert(a != NULL);
 
     a->start_x = start_x;
     a->start_y = start_y;
     a->size_x = size_x;
     a->size_y = size_y;
 
-    a->area = g_malloc0(size_y * sizeof(int *));
+    memset(a->rows, 0, sizeof(a->rows));
+}
+
+void area_init_circle(area *a, position center, guint radius, gboolean hollow)
+{
+    g_assert(pos_valid(center));
+
+    const int r = radius;
+
+    area_init(a, X(center) - r, Y(center) - r, 2 * r + 1, 2 * r + 1);
+    area_circle_put(a->rows, center, r, hollow ? ACT_RING : ACT_DISC);
+}
+
+void area_init_circle_flooded(area *a, position center, guint radius,
+                              const area *obstacles)
+{
+    guint64 allowed[MAP_MAX_Y][AREA_WORDS];
+
+    g_assert(radius > 0 && obstacles != NULL && pos_valid(center));
+
+    const int r = radius;
+
+    area_init(a, X(center) - r, Y(center) - r, 2 * r + 1, 2 * r + 1);
+
+    g_assert(a->start_x == obstacles->start_x && a->size_x == obstacles->size_x);
+    g_assert(a->start_y == obstacles->start_y && a->size_y == obstacles->size_y);
+
+    /* the flood can reach every unobstructed point inside the circle */
+    memset(allowed, 0, sizeof(allowed));
+    area_circle_put(allowed, center, r, ACT_INTERIOR);
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int w = 0; w < AREA_WORDS; w++)
+            allowed[y][w] &= ~obstacles->rows[y][w];
+
+    area_spread(a, allowed, X(center), Y(center));
+}
+
+gboolean area_blast(position center, guint radius,
+                    const damage_originator *damo,
+                    area_hit_sth pos_hitfun,
+                    gpointer data1, gpointer data2,
+                    char glyph, int colour)
+{
+    map *cmap = game_map(nlarn, Z(center));
+    position cursor = center;
+    gboolean retval = FALSE;
+    area ball, obsmap;
+
+    map_get_obstacles(cmap, center, radius, TRUE, &obsmap);
+    area_init_circle_flooded(&ball, center, radius, &obsmap);
+
+    /* show the blast before anything is harmed */
+    display_paint_blast(cmap, &ball, glyph, colour);
+
+    for (Y(cursor) = ball.start_y; Y(cursor) < ball.start_y + ball.size_y; Y(cursor)++)
+    {
+        for (X(cursor) = ball.start_x; X(cursor) < ball.start_x + ball.size_x; X(cursor)++)
+        {
+            /* skip this position if it is not affected by the blast */
+            if (!area_pos_get(&ball, cursor))
+                continue;
+
+            /* keep track if the blast hit something */
+            if (pos_hitfun(cursor, damo, data1, data2))
+                retval = TRUE;
+        }
+    }
+
+    /* make sure the blast shows up */
+    display_draw();
+
+    /* sleep a 3/4 second */
+    display_delay(750);
+
+    return retval;
+}
+
+void area_add(area *a, const area *b)
+{
+    g_assert (a != NULL && b != NULL);
+    g_assert (a->size_x == b->size_x && a->size_y == b->size_y);
+    g_assert (a->start_x == b->start_x && a->start_y == b->start_y);
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int w = 0; w < AREA_WORDS; w++)
+            a->rows[y][w] |= b->rows[y][w];
+}
+
+void area_flood(area *flood, const area *obstacles, int start_x, int start_y)
+{
+    guint64 allowed[MAP_MAX_Y][AREA_WORDS];
+
+    g_assert (obstacles != NULL && area_point_valid(obstacles, start_x, start_y));
+
+    area_init(flood, obstacles->start_x, obstacles->start_y,
+              obstacles->size_x, obstacles->size_y);
+
+    /* the flood is confined to the unobstructed points of the bounding box */
+    area_box_mask(obstacles, allowed);
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int w = 0; w < AREA_WORDS; w++)
+            allowed[y][w] &= ~obstacles->rows[y][w];
+
+    area_spread(flood, allowed, obstacles->start_x + start_x,
+                obstacles->start_y + start_y);
+}
+
+void area_point_set(area *a, int x, int y)
+{
+    g_assert(a != NULL);
+    g_assert(area_point_valid(a, x, y));
+
+    x += a->start_x;
+    y += a->start_y;
+
+    /* points outside the map are not stored */
+    if (x < 0 || x >= MAP_MAX_X || y < 0 || y >= MAP_MAX_Y)
+        return;
+
+    a->rows[y][x / 64] |= G_GUINT64_CONSTANT(1) << (x % 64);
+}
+
+int area_point_get(const area *a, int x, int y)
+{
+    g_assert (a != NULL);
+
+    if (!area_point_valid(a, x, y))
+        return FALSE;
+
+    x += a->start_x;
+    y += a->start_y;
+
+    if (x < 0 || x >= MAP_MAX_X || y < 0 || y >= MAP_MAX_Y)
+        return FALSE;
+
+    return (a->rows[y][x / 64] >> (x % 64)) & 1;
+}
+
+int area_point_valid(const area *a, int x, int y)
+{
+    g_assert (a != NULL);
+    return ((x < a->size_x) && (x >= 0)) && ((y < a->size_y) && (y >= 0));
+}
+
+int area_pos_get(const area *a, position pos)
+{
+    int x, y;
+
+    g_assert (a != NULL);
+
+    x = X(pos) - a->start_x;
+    y = Y(pos) - a->start_y;
+
+    return area_point_get(a, x, y);
+}
+
+/* circles are calculated in a grid of bytes, one per point of the square
+   enclosing the circle */
+static inline void area_circle_set(guint8 *grid, int radius, int dx, int dy)
+{
+    grid[(dy + radius) * (2 * radius + 1) + dx + radius] = TRUE;
+}
 
-    for (int y = 0; y < size_y; y++)
-        a->area[y] = g_malloc0(size_x * sizeof(int));
+static inline gboolean area_circle_get(const guint8 *grid, int radius, int dx, int dy)
+{
+    if (dx < -radius || dx > radius || dy < -radius || dy > radius)
+        return FALSE;
 
-    return a;
+    return grid[(dy + radius) * (2 * radius + 1) + dx + radius];
 }
 
-area *area_new_circle(position center, guint radius, gboolean hollow)
+static void area_circle_calc(int radius, guint8 *ring, guint8 *disc, guint8 *interior)
 {
-    area *circle;
+    const int size = 2 * radius + 1;
 
     int f = 1 - radius;
     int ddF_x = 1;
@@ -236,29 +425,13 @@ area *area_new_circle(position center, guint radius, gboolean hollow)
     int x = 0;
     int y = radius;
 
-    if (!pos_valid(center))
-        return NULL;
-
-    circle = area_new(X(center) - radius,
-                      Y(center) - radius,
-                      2 * radius + 1,
-                      2 * radius + 1);
-
-    /* reposition the center to relative values */
-    X(center) = radius;
-    Y(center) = radius;
-
-    area_point_set(circle, X(center), Y(center) + radius);
-    area_point_set(circle, X(center), Y(center) - radius);
-    area_point_set(circle, X(center) + radius, Y(center));
-    area_point_set(circle, X(center) - radius, Y(center));
+    area_circle_set(ring, radius, 0, radius);
+    area_circle_set(ring, radius, 0, -radius);
+    area_circle_set(ring, radius, radius, 0);
+    area_circle_set(ring, radius, -radius, 0);
 
     while (x < y)
     {
-        g_assert(ddF_x == 2 * x + 1);
-        g_assert(ddF_y == -2 * y);
-        g_assert(f == x * x + y * y - (int)radius * (int)radius + 2 * x - y + 1);
-
         if (f >= 0)
         {
             y--;
@@ -270,19 +443,16 @@ area *area_new_circle(position center, guint radius, gboolean hollow)
         ddF_x += 2;
         f += ddF_x;
 
-        area_point_set(circle, X(center) + x, Y(center) + y);
-        area_point_set(circle, X(center) - x, Y(center) + y);
-        area_point_set(circle, X(center) + x, Y(center) - y);
-        area_point_set(circle, X(center) - x, Y(center) - y);
-        area_point_set(circle, X(center) + y, Y(center) + x);
-        area_point_set(circle, X(center) - y, Y(center) + x);
-        area_point_set(circle, X(center) + y, Y(center) - x);
-        area_point_set(circle, X(center) - y, Y(center) - x);
+        area_circle_set(ring, radius, x, y);
+        area_circle_set(ring, radius, -x, y);
+        area_circle_set(ring, radius, x, -y);
+        area_circle_set(ring, radius, -x, -y);
+        area_circle_set(ring, radius, y, x);
+        area_circle_set(ring, radius, -y, x);
+        area_circle_set(ring, radius, y, -x);
+        area_circle_set(ring, radius, -y, -x);
     }
 
-    if (hollow)
-        return circle;
-
     /* fill the circle
      * - set fill to TRUE when spotting the left border
      * - set position if (fill == TRUE)
@@ -290,224 +460,206 @@ area *area_new_circle(position center, guint radius, gboolean hollow)
      *
      * do not need to fill the first and last row
      */
+    memcpy(disc, ring, size * size);
 
-    for (y = 1; y < circle->size_y - 1; y++)
+    for (int dy = 1 - radius; dy < radius; dy++)
     {
         gboolean fill = FALSE;
 
-        for (x = 0; x < circle->size_x; x++)
+        for (int dx = -radius; dx <= radius; dx++)
         {
             /* there are double dots at the beginning and the end of the square */
-            if (area_point_get(circle, x, y) && (!area_point_get(circle, x + 1, y)))
+            if (area_circle_get(ring, radius, dx, dy)
+                    && !area_circle_get(ring, radius, dx + 1, dy))
             {
                 fill = !fill;
                 continue;
             }
 
             if (fill)
-            {
-                area_point_set(circle, x, y);
-            }
+                area_circle_set(disc, radius, dx, dy);
         }
     }
 
-    return circle;
+    /* The hollow circle is 8-connected, thus the points enclosed by it are
+       those of the filled circle which are not part of the hollow one. */
+    for (int idx = 0; idx < size * size; idx++)
+        interior[idx] = disc[idx] && !ring[idx];
 }
 
-area *area_new_circle_flooded(position center, guint radius, area *obstacles)
+static void area_circles_init()
 {
-    area *narea;
-    int start_x, start_y;
+    static gsize initialised = 0;
 
-    g_assert(radius > 0 && obstacles != NULL);
+    if (!g_once_init_enter(&initialised))
+        return;
 
-    if (!pos_valid(center))
-        return NULL;
+    const int size_max = 2 * AREA_MAX_RADIUS + 1;
+    guint8 *grids = g_malloc(ACT_MAX * size_max * size_max);
 
-    /* add circle boundary to obstacle map */
-    obstacles = area_add(obstacles, area_new_circle(center, radius, TRUE));
+    for (int radius = 0; radius <= AREA_MAX_RADIUS; radius++)
+    {
+        const int size = 2 * radius + 1;
 
-    /* translate absolute center position to area */
-    start_x = X(center) - obstacles->start_x;
-    start_y = Y(center) - obstacles->start_y;
+        memset(grids, 0, ACT_MAX * size * size);
+        area_circle_calc(radius, grids, grids + size * size,
+                         grids + 2 * size * size);
 
-    /* fill narea */
-    narea = area_flood(obstacles, start_x, start_y);
+        /* pack the grids into the table */
+        for (area_circle_type type = 0; type < ACT_MAX; type++)
+        {
+            const guint8 *grid = grids + type * size * size;
+
+            for (int row = 0; row < size; row++)
+                for (int col = 0; col < size; col++)
+                {
+                    if (grid[row * size + col])
+                        area_circles[type][radius][row] |= G_GUINT64_CONSTANT(1) << col;
+                }
+        }
+    }
 
-    return narea;
+    g_free(grids);
+    g_once_init_leave(&initialised, 1);
 }
 
-gboolean area_blast(position center, guint radius,
-                    const damage_originator *damo,
-                    area_hit_sth pos_hitfun,
-                    gpointer data1, gpointer data2,
-                    char glyph, int colour)
+/* add the points of a circle which lie inside the map to the rows of an area */
+static void area_circle_put(guint64 rows[MAP_MAX_Y][AREA_WORDS], position center,
+                            int radius, area_circle_type type)
 {
-    map *cmap = game_map(nlarn, Z(center));
-    position cursor = center;
-    gboolean retval = FALSE;
-    area *ball, *obsmap;
-
-    obsmap = map_get_obstacles(cmap, center, radius, TRUE);
-    ball = area_new_circle_flooded(center, radius, obsmap);
+    if (radius <= AREA_MAX_RADIUS)
+    {
+        area_circles_init();
 
-    attron(colour);
+        const guint64 *circle = area_circles[type][radius];
 
-    for (Y(cursor) = ball->start_y; Y(cursor) < ball->start_y + ball->size_y; Y(cursor)++)
-    {
-        for (X(cursor) = ball->start_x; X(cursor) < ball->start_x + ball->size_x; X(cursor)++)
+        for (int dy = -radius; dy <= radius; dy++)
         {
-            monster *m = NULL;
-
-            /* skip this position if it is not affected by the blast */
-            if (!area_pos_get(ball, cursor))
+            if (Y(center) + dy < 0 || Y(center) + dy >= MAP_MAX_Y)
                 continue;
 
-            /* move the cursor to the position */
-            move(Y(cursor), X(cursor));
-
-            if (map_sobject_at(cmap, cursor))
-            {
-                /* The blast hit a stationary object. */
-                addch(so_get_glyph(map_sobject_at(cmap, cursor)));
-            }
-            else if ((m = map_get_monster_at(cmap, cursor)))
-            {
-                /* The blast hit a monster */
-                if (monster_in_sight(m))
-                    addch(monster_glyph(m));
-                else
-                    addch(glyph);
-            }
-            else if (pos_identical(nlarn->p->pos, cursor))
-            {
-                /* The blast hit the player */
-                addch('@');
-            }
-            else
-            {
-                /* The blast hit nothing */
-                addch(glyph);
-            }
-
-            /* keep track if the blast hit something */
-            if (pos_hitfun(cursor, damo, data1, data2))
-                retval = TRUE;
+            area_row_put(rows[Y(center) + dy], circle[dy + radius], X(center) - radius);
         }
-    }
 
-    area_destroy(ball);
-    attroff(colour);
-
-    /* make sure the blast shows up */
-    display_draw();
-
-    /* sleep a 3/4 second */
-    napms(750);
-
-    return retval;
-}
+        return;
+    }
 
-void area_destroy(area *a)
-{
-    g_assert(a != NULL);
+    /* the circle is too large for the table, calculate it for this call */
+    const int size = 2 * radius + 1;
+    guint8 *grids = g_malloc0(ACT_MAX * size * size);
 
-    for (int y = 0; y < a->size_y; y++)
-        g_free(a->area[y]);
+    area_circle_calc(radius, grids, grids + size * size, grids + 2 * size * size);
 
-    g_free(a->area);
+    const guint8 *grid = grids + type * size * size;
 
-    g_free(a);
-}
+    for (int dy = -radius; dy <= radius; dy++)
+    {
+        const int y = Y(center) + dy;
 
-area *area_add(area *a, area *b)
-{
-    g_assert (a != NULL && b != NULL);
-    g_assert (a->size_x == b->size_x && a->size_y == b->size_y);
+        if (y < 0 || y >= MAP_MAX_Y)
+            continue;
 
-    for (int y = 0; y < a->size_y; y++)
-    {
-        for (int x = 0; x < a->size_x; x++)
+        for (int dx = -radius; dx <= radius; dx++)
         {
-            if (area_point_get(b, x, y))
-            {
-                area_point_set(a, x, y);
-            }
+            const int x = X(center) + dx;
+
+            if (x >= 0 && x < MAP_MAX_X && area_circle_get(grid, radius, dx, dy))
+                rows[y][x / 64] |= G_GUINT64_CONSTANT(1) << (x % 64);
         }
     }
 
-    area_destroy(b);
-
-    return a;
+    g_free(grids);
 }
 
-area *area_flood(area *obstacles, int start_x, int start_y)
+/* set the bits of mask in a row of an area, bit 0 of the mask at x = offset */
+static void area_row_put(guint64 *row, guint64 mask, int offset)
 {
-    g_assert (obstacles != NULL && area_point_valid(obstacles, start_x, start_y));
+    if (offset < 0)
+    {
+        if (offset <= -64)
+            return;
 
-    area *flood = area_new(obstacles->start_x, obstacles->start_y,
-                           obstacles->size_x, obstacles->size_y);
+        mask >>= -offset;
+        offset = 0;
+    }
 
-    area_flood_worker(flood, obstacles, start_x, start_y);
+    const int word = offset / 64;
+    const int bit = offset % 64;
 
-    area_destroy(obstacles);
+    if (word < AREA_WORDS)
+        row[word] |= mask << bit;
 
-    return flood;
-}
+    if (bit && word + 1 < AREA_WORDS)
+        row[word + 1] |= mask >> (64 - bit);
 
-void area_point_set(area *a, int x, int y)
-{
-    g_assert(a != NULL);
-    g_assert(area_point_valid(a, x, y));
-    a->area[y][x] = TRUE;
+    /* drop the points beyond the map's right border */
+    row[AREA_WORDS - 1] &= AREA_LAST_WORD_MASK;
 }
 
-int area_point_get(area *a, int x, int y)
+/* get the points of an area's bounding box which lie inside the map */
+static void area_box_mask(const area *a, guint64 rows[MAP_MAX_Y][AREA_WORDS])
 {
-    g_assert (a != NULL);
+    memset(rows, 0, MAP_MAX_Y * sizeof(rows[0]));
 
-    if (!area_point_valid(a, x, y))
-        return FALSE;
-
-    return a->area[y][x];
+    for (int y = max(a->start_y, 0);
+            y < min(a->start_y + a->size_y, MAP_MAX_Y); y++)
+    {
+        for (int x = max(a->start_x, 0);
+                x < min(a->start_x + a->size_x, MAP_MAX_X); x++)
+        {
+            rows[y][x / 64] |= G_GUINT64_CONSTANT(1) << (x % 64);
+        }
+    }
 }
 
-int area_point_valid(area *a, int x, int y)
+/* flood fill from the absolute position x, y; spreads in all four
+   directions at once until every reachable allowed point has been set */
+static void area_spread(area *flood, guint64 allowed[MAP_MAX_Y][AREA_WORDS],
+                        int x, int y)
 {
-    g_assert (a != NULL);
-    return ((x < a->size_x) && (x >= 0)) && ((y < a->size_y) && (y >= 0));
-}
+    /* can't flood this */
+    if (x < 0 || x >= MAP_MAX_X || y < 0 || y >= MAP_MAX_Y
+            || !((allowed[y][x / 64] >> (x % 64)) & 1))
+    {
+        return;
+    }
 
-int area_pos_get(area *a, position pos)
-{
-    int x, y;
+    flood->rows[y][x / 64] |= G_GUINT64_CONSTANT(1) << (x % 64);
 
-    g_assert (a != NULL);
+    gboolean changed;
+    do
+    {
+        changed = FALSE;
 
-    x = X(pos) - a->start_x;
-    y = Y(pos) - a->start_y;
+        for (int row = 0; row < MAP_MAX_Y; row++)
+        {
+            for (int w = 0; w < AREA_WORDS; w++)
+            {
+                const guint64 cur = flood->rows[row][w];
+                guint64 grown = cur | (cur << 1) | (cur >> 1);
 
-    return area_point_get(a, x, y);
-}
+                /* carry the neighbouring words' edge bits over */
+                if (w > 0)
+                    grown |= flood->rows[row][w - 1] >> 63;
 
-static void area_flood_worker(area *flood, area *obstacles, int x, int y)
-{
-    /* stepped out of area */
-    if (!area_point_valid(flood, x, y))
-        return;
+                if (w < AREA_WORDS - 1)
+                    grown |= flood->rows[row][w + 1] << 63;
 
-    /* can't flood this */
-    if (area_point_get(obstacles, x, y))
-        return;
+                if (row > 0)
+                    grown |= flood->rows[row - 1][w];
 
-    /* been here before */
-    if (area_point_get(flood, x, y))
-        return;
+                if (row < MAP_MAX_Y - 1)
+                    grown |= flood->rows[row + 1][w];
 
-    area_point_set(flood, x, y);
+                grown &= allowed[row][w];
 
-    area_flood_worker(flood, obstacles, x + 1, y);
-    area_flood_worker(flood, obstacles, x - 1, y);
-    area_flood_worker(flood, obstacles, x, y + 1);
-    area_flood_worker(flood, obstacles, x, y - 1);
+                if (grown != cur)
+                {
+                    flood->rows[row][w] = grown;
+                    changed = TRUE;
+                }
+            }
+        }
+    }
+    while (changed);
 }
@@ -62,7 +62,7 @@ static int potion_detect_item(struct player *p, item *potion);
 static int potion_recovery(struct player *p, item *potion);
 static int potion_holy_water(player *p, item *potion);
 
-static gboolean potion_pos_hit(const GList *traj,
+static gboolean potion_pos_hit(const position_span *traj, guint idx,
         const damage_originator *damo,
         gpointer data1, gpointer data2);
 
@@ -238,8 +238,8 @@ item_usage_result potion_quaff(struct player *p, item *potion)
 
     if (potion->cursed)
     {
-        damage *dam = damage_new(DAM_POISON, ATT_NONE, rand_1n(p->hp),
-                                 DAMO_ITEM, NULL);
+        damage dam = damage_new(DAM_POISON, ATT_NONE, rand_1n(p->hp),
+                                DAMO_ITEM, NULL);
 
         log_add_entry(nlarn->log, "The potion is foul!");
 
@@ -403,7 +403,7 @@ static int potion_detect_item(player *p, item *potion)
                         if ((it->type == IT_GOLD) || (it->type == IT_GEM))
                         {
                             player_memory_of(p, pos).item = it->type;
-                            player_memory_of(p, pos).item_colour = item_colour(it);
+                            player_memory_of(p, pos).item_colour = display_colour_index(item_colour(it));
                             found_item = TRUE;
                             count++;
                             break;
@@ -414,7 +414,7 @@ static int potion_detect_item(player *p, item *potion)
                         if ((it->type != IT_GOLD) && (it->type != IT_GEM))
                         {
                             player_memory_of(p, pos).item = it->type;
-                            player_memory_of(p, pos).item_colour = item_colour(it);
+                            player_memory_of(p, pos).item_colour = display_colour_index(item_colour(it));
                             found_item = TRUE;
                             count++;
                             break;
@@ -460,7 +460,7 @@ static int potion_detect_item(player *p, item *potion)
                        don't move around */
 
                     player_memory_of(p, pos).item = item_type;
-                    player_memory_of(p, pos).item_colour = DARKGRAY;
+                    player_memory_of(p, pos).item_colour = display_colour_index(DARKGRAY);
                     count++;
                 }
             }
@@ -560,13 +560,13 @@ static int potion_holy_water(player *p, item *potion __attribute__((unused)))
     return FALSE;
 }
 
-static gboolean potion_pos_hit(const GList *traj,
+static gboolean potion_pos_hit(const position_span *traj, guint idx,
                                const damage_originator *damo __attribute__((unused)),
                                gpointer data1,
                                gpointer data2 __attribute__((unused)))
 {
     item *potion = (item *)data1;
-    position pos; pos_val(pos) = GPOINTER_TO_UINT(traj->data);
+    position pos = traj->pos[idx];
     map *pmap = game_map(nlarn, Z(pos));
     map_tile_t mtt = map_tiletype_at(pmap, pos);
     sobject_t mst = map_sobject_at(pmap, pos);
@@ -611,8 +611,8 @@ static gboolean potion_pos_hit(const GList *traj,
             log_add_entry(nlarn->log, "Smoke emerges where %s pours over the %s.",
                           desc, monster_get_name(m));
 
-            damage *dam = damage_new(DAM_PHYSICAL, ATT_TOUCH, rand_1n(monster_hp(m) + 1),
-                                     DAMO_PLAYER, nlarn->p);
+            damage dam = damage_new(DAM_PHYSICAL, ATT_TOUCH, rand_1n(monster_hp(m) + 1),
+                                    DAMO_PLAYER, nlarn->p);
 
             monster_damage_take(m, dam);
         }
@@ -0,0 +1,138 @@
+/*
+ * pqueue.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "pqueue.h"
+
+typedef struct pqueue_entry
+{
+    guint32 key;        /* priority of the element */
+    guint32 seq;        /* insertion counter to keep the order stable */
+    gpointer data;      /* the element */
+} pqueue_entry;
+
+struct _pqueue
+{
+    GArray *heap;       /* binary heap of pqueue_entry */
+    guint32 seq;        /* sequence number of the next element */
+};
+
+static inline gboolean pqueue_less(const pqueue_entry *a, const pqueue_entry *b)
+{
+    return (a->key < b->key) || (a->key == b->key && a->seq < b->seq);
+}
+
+pqueue *pqueue_new()
+{
+    pqueue *q = g_malloc0(sizeof(pqueue));
+    q->heap = g_array_new(FALSE, FALSE, sizeof(pqueue_entry));
+
+    return q;
+}
+
+void pqueue_destroy(pqueue *q)
+{
+    g_assert(q != NULL);
+
+    g_array_free(q->heap, TRUE);
+    g_free(q);
+}
+
+void pqueue_push(pqueue *q, guint32 key, gpointer data)
+{
+    pqueue_entry entry = { key, q->seq++, data };
+    pqueue_entry *heap;
+    guint pos;
+
+    g_assert(q != NULL);
+
+    g_array_append_val(q->heap, entry);
+    heap = (pqueue_entry *)q->heap->data;
+
+    /* move the new entry up until its parent is smaller */
+    for (pos = q->heap->len - 1; pos > 0; pos = (pos - 1) / 2)
+    {
+        const guint parent = (pos - 1) / 2;
+
+        if (!pqueue_less(&entry, &heap[parent]))
+            break;
+
+        heap[pos] = heap[parent];
+    }
+
+    heap[pos] = entry;
+}
+
+gpointer pqueue_pop(pqueue *q, guint32 *key)
+{
+    pqueue_entry *heap;
+    pqueue_entry top, last;
+    guint pos = 0, len;
+
+    g_assert(q != NULL);
+
+    if (q->heap->len == 0)
+        return NULL;
+
+    heap = (pqueue_entry *)q->heap->data;
+    top = heap[0];
+    last = heap[q->heap->len - 1];
+    len = q->heap->len - 1;
+    g_array_set_size(q->heap, len);
+
+    /* move the former last entry down from the top */
+    while (len > 0)
+    {
+        guint child = 2 * pos + 1;
+
+        if (child >= len)
+            break;
+
+        if (child + 1 < len && pqueue_less(&heap[child + 1], &heap[child]))
+            child++;
+
+        if (!pqueue_less(&heap[child], &last))
+            break;
+
+        heap[pos] = heap[child];
+        pos = child;
+    }
+
+    if (len > 0)
+        heap[pos] = last;
+
+    if (key != NULL)
+        *key = top.key;
+
+    return top.data;
+}
+
+void pqueue_clear(pqueue *q)
+{
+    g_assert(q != NULL);
+
+    g_array_set_size(q->heap, 0);
+    q->seq = 0;
+}
+
+guint pqueue_length(pqueue *q)
+{
+    g_assert(q != NULL);
+    return q->heap->len;
+}
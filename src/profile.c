@@ -0,0 +1,491 @@
+/*
+ * profile.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* clock_gettime() is only declared when this is set */
+#if (defined __unix) || (defined __unix__) || (defined __APPLE__)
+# ifndef _POSIX_C_SOURCE
+#  define _POSIX_C_SOURCE 199309L
+# endif
+#endif
+
+#include <glib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "profile.h"
+#include "utils.h"
+
+/*
+ * The per-turn histograms have logarithmic buckets: bucket 0 counts the
+ * turns without time spent in the function, bucket n the turns with
+ * at least 2^(n-1) and less than 2^n microseconds.
+ */
+#define PROFILE_BUCKETS 24
+
+typedef struct _profile_counter
+{
+    guint64 calls;
+    gint64 total;           /* ns */
+    gint64 turn;            /* ns spent during the current turn */
+    gint64 turn_max;        /* ns spent during the slowest turn */
+    guint32 histogram[PROFILE_BUCKETS];
+} profile_counter;
+
+static const char *profile_phase_names[PP_MAX] =
+{
+    "turn",
+    "map_timer",
+    "monster_act",
+    "path_find",
+    "fov_calculate",
+    "player_update_fov",
+    "display_paint_screen",
+    "game_save",
+    "inv_add",
+};
+
+typedef struct _profile_account
+{
+    guint64 allocs;         /* number of objects ever allocated */
+    gint64 objects;         /* live objects */
+    gint64 bytes;           /* live bytes */
+    gint64 bytes_peak;
+} profile_account;
+
+static const char *profile_memory_names[PM_MAX] =
+{
+    "items",
+    "effects",
+    "monsters",
+    "maps",
+    "inventories",
+    "message_log",
+    "player_memory",
+    "save_buffers",
+};
+
+static THREAD_LOCAL profile_counter profile_counters[PP_MAX];
+static THREAD_LOCAL guint32 profile_turns = 0;
+static THREAD_LOCAL profile_account profile_accounts[PM_MAX];
+
+/* the files written by profile_write_on_exit() and
+   profile_memory_write_on_exit(); process-wide, see game.h */
+static char *profile_output = NULL;
+static char *profile_memory_output = NULL;
+
+/* the trace file shared by all threads */
+static FILE *profile_trace = NULL;
+static gint64 profile_trace_events = 0;
+G_LOCK_DEFINE_STATIC(profile_trace);
+
+/* the thread's ID in the trace */
+static THREAD_LOCAL gint profile_thread = 0;
+static gint profile_threads = 0;
+
+static gint64 profile_count(profile_phase phase, gint64 start);
+static guint profile_bucket(gint64 ns);
+static gint64 profile_percentile(profile_counter *pc, guint percent);
+static void profile_write();
+static void profile_memory_write();
+static void profile_write_json(const char *filename, cJSON *data);
+static void profile_trace_event(const char *name, char type, gint64 start,
+                                gint64 duration, const char *args);
+static void profile_trace_finish();
+static void profile_json_append(GString *str, const char *text);
+
+gint64 profile_begin()
+{
+#if (defined __unix) || (defined __unix__) || (defined __APPLE__)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (gint64)ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+#else
+    return g_get_monotonic_time() * 1000;
+#endif
+}
+
+void profile_end(profile_phase phase, gint64 start)
+{
+    gint64 duration = profile_count(phase, start);
+
+    /* inv_add() is called far too often to be of interest in the trace */
+    if (profile_trace && phase != PP_INV_ADD)
+        profile_trace_event(profile_phase_names[phase], 'X', start, duration, NULL);
+}
+
+void profile_end_tagged(profile_phase phase, gint64 start, ...)
+{
+    gint64 duration = profile_count(phase, start);
+
+    if (!profile_trace)
+        return;
+
+    GString *args = g_string_new(NULL);
+    const char *name;
+    va_list tags;
+
+    va_start(tags, start);
+    while ((name = va_arg(tags, const char *)))
+    {
+        const char *value = va_arg(tags, const char *);
+
+        if (args->len)
+            g_string_append_c(args, ',');
+
+        profile_json_append(args, name);
+        g_string_append_c(args, ':');
+        profile_json_append(args, value ? value : "none");
+    }
+    va_end(tags);
+
+    profile_trace_event(profile_phase_names[phase], 'X', start, duration, args->str);
+    g_string_free(args, TRUE);
+}
+
+void profile_trace_counter(const char *name, gint64 value)
+{
+    if (!profile_trace)
+        return;
+
+    char *args = g_strdup_printf("\"%s\":%" G_GINT64_FORMAT, name, value);
+    profile_trace_event(name, 'C', profile_begin(), 0, args);
+    g_free(args);
+}
+
+gboolean profile_trace_start(const char *filename)
+{
+    g_assert(filename != NULL && profile_trace == NULL);
+
+    if (!(profile_trace = fopen(filename, "w")))
+        return FALSE;
+
+    fputs("[\n", profile_trace);
+    atexit(profile_trace_finish);
+
+    return TRUE;
+}
+
+void profile_turn_end()
+{
+    for (profile_phase phase = 0; phase < PP_MAX; phase++)
+    {
+        profile_counter *pc = &profile_counters[phase];
+
+        pc->histogram[profile_bucket(pc->turn)]++;
+        pc->turn_max = max(pc->turn_max, pc->turn);
+        pc->turn = 0;
+    }
+
+    profile_turns++;
+}
+
+void profile_alloc(profile_memory subsystem, gsize size)
+{
+    profile_account *pa = &profile_accounts[subsystem];
+
+    pa->allocs++;
+    pa->objects++;
+    pa->bytes += size;
+    pa->bytes_peak = MAX(pa->bytes_peak, pa->bytes);
+}
+
+void profile_free(profile_memory subsystem, gsize size)
+{
+    profile_account *pa = &profile_accounts[subsystem];
+
+    pa->objects--;
+    pa->bytes -= size;
+}
+
+char *profile_report()
+{
+    GString *report = g_string_new(NULL);
+
+    g_string_append_printf(report, "Turns measured: %u\n\n", profile_turns);
+    g_string_append(report, "Function              Calls    Total  Per call"
+                            "   Per turn (p50/p90/max)\n");
+
+    for (profile_phase phase = 0; phase < PP_MAX; phase++)
+    {
+        profile_counter *pc = &profile_counters[phase];
+
+        g_string_append_printf(report,
+                "%-20s %6" G_GUINT64_FORMAT " %6" G_GINT64_FORMAT "ms"
+                " %7" G_GINT64_FORMAT "us"
+                " %6" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "us\n",
+                profile_phase_names[phase], pc->calls, pc->total / 1000000,
+                pc->calls ? pc->total / (gint64)pc->calls / 1000 : 0,
+                profile_percentile(pc, 50), profile_percentile(pc, 90),
+                pc->turn_max / 1000);
+    }
+
+    return g_string_free(report, FALSE);
+}
+
+char *profile_memory_report()
+{
+    GString *report = g_string_new(NULL);
+    gint64 total = 0;
+
+    g_string_append(report, "Subsystem          Objects    Live kB    Peak kB"
+                            "     Allocated\n");
+
+    for (profile_memory pm = 0; pm < PM_MAX; pm++)
+    {
+        profile_account *pa = &profile_accounts[pm];
+
+        g_string_append_printf(report,
+                "%-16s %9" G_GINT64_FORMAT " %10" G_GINT64_FORMAT
+                " %10" G_GINT64_FORMAT " %13" G_GUINT64_FORMAT "\n",
+                profile_memory_names[pm], pa->objects, pa->bytes / 1024,
+                pa->bytes_peak / 1024, pa->allocs);
+
+        total += pa->bytes;
+    }
+
+    g_string_append_printf(report, "\nTotal live: %" G_GINT64_FORMAT " kB\n",
+                           total / 1024);
+
+    return g_string_free(report, FALSE);
+}
+
+cJSON *profile_serialize()
+{
+    cJSON *pser = cJSON_CreateObject();
+    cJSON *phases = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(pser, "turns", profile_turns);
+    cJSON_AddItemToObject(pser, "phases", phases);
+
+    for (profile_phase phase = 0; phase < PP_MAX; phase++)
+    {
+        profile_counter *pc = &profile_counters[phase];
+        cJSON *phser = cJSON_CreateObject();
+        int histogram[PROFILE_BUCKETS];
+
+        for (int bucket = 0; bucket < PROFILE_BUCKETS; bucket++)
+            histogram[bucket] = pc->histogram[bucket];
+
+        cJSON_AddNumberToObject(phser, "calls", pc->calls);
+        cJSON_AddNumberToObject(phser, "total_ns", pc->total);
+        cJSON_AddNumberToObject(phser, "turn_max_ns", pc->turn_max);
+        cJSON_AddItemToObject(phser, "turn_histogram_log2_us",
+                              cJSON_CreateIntArray(histogram, PROFILE_BUCKETS));
+
+        cJSON_AddItemToObject(phases, profile_phase_names[phase], phser);
+    }
+
+    return pser;
+}
+
+cJSON *profile_memory_serialize()
+{
+    cJSON *mser = cJSON_CreateObject();
+
+    for (profile_memory pm = 0; pm < PM_MAX; pm++)
+    {
+        profile_account *pa = &profile_accounts[pm];
+        cJSON *pmser = cJSON_CreateObject();
+
+        cJSON_AddNumberToObject(pmser, "objects", pa->objects);
+        cJSON_AddNumberToObject(pmser, "bytes", pa->bytes);
+        cJSON_AddNumberToObject(pmser, "bytes_peak", pa->bytes_peak);
+        cJSON_AddNumberToObject(pmser, "allocations", pa->allocs);
+
+        cJSON_AddItemToObject(mser, profile_memory_names[pm], pmser);
+    }
+
+    return mser;
+}
+
+void profile_write_on_exit(const char *filename)
+{
+    g_assert(filename != NULL);
+
+    if (profile_output == NULL)
+        atexit(profile_write);
+
+    g_free(profile_output);
+    profile_output = g_strdup(filename);
+}
+
+void profile_memory_write_on_exit(const char *filename)
+{
+    g_assert(filename != NULL);
+
+    if (profile_memory_output == NULL)
+        atexit(profile_memory_write);
+
+    g_free(profile_memory_output);
+    profile_memory_output = g_strdup(filename);
+}
+
+static gint64 profile_count(profile_phase phase, gint64 start)
+{
+    profile_counter *pc = &profile_counters[phase];
+    gint64 duration = profile_begin() - start;
+
+    pc->calls++;
+    pc->total += duration;
+    pc->turn += duration;
+
+    return duration;
+}
+
+static guint profile_bucket(gint64 ns)
+{
+    gint64 us = ns / 1000;
+    guint bucket = 0;
+
+    while (us > 0 && bucket < PROFILE_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static gint64 profile_percentile(profile_counter *pc, guint percent)
+{
+    guint64 wanted = ((guint64)profile_turns * percent + 99) / 100;
+    guint64 seen = 0;
+
+    if (profile_turns == 0)
+        return 0;
+
+    /* return the upper bound of the bucket containing the percentile */
+    for (int bucket = 0; bucket < PROFILE_BUCKETS; bucket++)
+    {
+        seen += pc->histogram[bucket];
+
+        if (seen >= wanted)
+            return bucket ? (G_GINT64_CONSTANT(1) << bucket) - 1 : 0;
+    }
+
+    return pc->turn_max / 1000;
+}
+
+static void profile_trace_event(const char *name, char type, gint64 start,
+                                gint64 duration, const char *args)
+{
+    if (profile_thread == 0)
+        profile_thread = g_atomic_int_add(&profile_threads, 1) + 1;
+
+    G_LOCK(profile_trace);
+
+    /* times are given in microseconds */
+    fprintf(profile_trace, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,"
+            "\"ts\":%" G_GINT64_FORMAT ".%03d",
+            profile_trace_events++ ? ",\n" : "", name, type, profile_thread,
+            start / 1000, (int)(start % 1000));
+
+    if (type == 'X')
+    {
+        fprintf(profile_trace, ",\"dur\":%" G_GINT64_FORMAT ".%03d",
+                duration / 1000, (int)(duration % 1000));
+    }
+
+    if (args != NULL)
+        fprintf(profile_trace, ",\"args\":{%s}", args);
+
+    fputc('}', profile_trace);
+
+    G_UNLOCK(profile_trace);
+}
+
+/* append text as a JSON string; UTF-8 is passed through unchanged */
+static void profile_json_append(GString *str, const char *text)
+{
+    g_string_append_c(str, '"');
+
+    for (const char *c = text; *c; c++)
+    {
+        switch (*c)
+        {
+        case '"':
+            g_string_append(str, "\\\"");
+            break;
+
+        case '\\':
+            g_string_append(str, "\\\\");
+            break;
+
+        case '\n':
+            g_string_append(str, "\\n");
+            break;
+
+        case '\t':
+            g_string_append(str, "\\t");
+            break;
+
+        default:
+            if ((unsigned char)*c < 0x20)
+                g_string_append_printf(str, "\\u%04x", (unsigned char)*c);
+            else
+                g_string_append_c(str, *c);
+            break;
+        }
+    }
+
+    g_string_append_c(str, '"');
+}
+
+static void profile_trace_finish()
+{
+    G_LOCK(profile_trace);
+
+    fputs("\n]\n", profile_trace);
+    fclose(profile_trace);
+    profile_trace = NULL;
+
+    G_UNLOCK(profile_trace);
+}
+
+static void profile_write()
+{
+    profile_write_json(profile_output, profile_serialize());
+}
+
+static void profile_memory_write()
+{
+    profile_write_json(profile_memory_output, profile_memory_serialize());
+}
+
+static void profile_write_json(const char *filename, cJSON *data)
+{
+    char *text = cJSON_Print(data);
+    FILE *out = fopen(filename, "w");
+
+    if (out != NULL)
+    {
+        fputs(text, out);
+        fclose(out);
+    }
+    else
+    {
+        g_printerr("Failed to write the profile to \"%s\".\n", filename);
+    }
+
+    free(text);
+    cJSON_Delete(data);
+}
@@ -16,18 +16,11 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifdef __linux__
-# define _XOPEN_SOURCE 700
-#endif
-#ifdef _WIN32
-# define _CRT_RAND_S
-#endif
-
 #include <glib.h>
 #include <stdint.h>
-#include <stdlib.h>
 
 #include "random.h"
+#include "utils.h"
 
 /* The following code is taken from xoshiro128starstar.c,
  * which is to be found on http://vigna.di.unimi.it/xorshift/ */
@@ -55,9 +48,7 @@ static inline uint32_t rotl(const uint32_t x, int k) {
 }
 
 
-static uint32_t s[4];
-
-uint32_t next(void) {
+static inline uint32_t next(uint32_t *s) {
 	const uint32_t result_starstar = rotl(s[0] * 5, 7) * 9;
 
 	const uint32_t t = s[1] << 9;
@@ -76,39 +67,68 @@ uint32_t next(void) {
 
 /* end xoshiro128starstar.c excerpt */
 
-static gboolean seeded = FALSE;
+/* the generator of the thread, used if no other generator has been selected */
+static THREAD_LOCAL rng_state rng_default;
+
+/* the generator selected by the thread */
+static THREAD_LOCAL rng_state *rng_selected = NULL;
+
+static inline rng_state *rng_current()
+{
+    return rng_selected ? rng_selected : &rng_default;
+}
 
 /* initialize RNG */
-static void rand_seed()
+static void rand_seed(rng_state *rng)
+{
+    g_assert(rng->seeded == FALSE);
+
+    /* GLib's generator is seeded from the system's entropy source and
+       can be used by many threads at once */
+    for (int i = 0; i < 4; i++)
+    {
+        rng->s[i] = g_random_int();
+    }
+
+    rng->seeded = TRUE;
+}
+
+void rand_use_state(rng_state *state)
 {
-    g_assert(seeded == FALSE);
+    rng_selected = state;
+}
 
-    /* On Windows, use rand_s to seed out RNG; otherwise use random() */
-#ifndef G_OS_WIN32
-    srandom(g_get_monotonic_time());
-#endif
+void rand_set_seed(guint32 seed)
+{
+    rng_state *rng = rng_current();
 
+    /* spread the seed over the entire state, see
+       https://github.com/aappleby/smhasher/wiki/MurmurHash3 */
     for (int i = 0; i < 4; i++)
     {
-#ifdef G_OS_WIN32
-        rand_s(&s[i]);
-#else
-        s[i] = random();
-#endif
+        guint32 z = (seed += 0x9e3779b9);
+
+        z = (z ^ (z >> 16)) * 0x85ebca6b;
+        z = (z ^ (z >> 13)) * 0xc2b2ae35;
+        rng->s[i] = z ^ (z >> 16);
     }
 
-    seeded = TRUE;
+    rng->seeded = TRUE;
 }
 
 cJSON* rand_serialize()
 {
-    g_assert(seeded == TRUE);
+    rng_state *rng = rng_current();
+
+    g_assert(rng->seeded == TRUE);
 
-    return cJSON_CreateIntArray((int*)&s, 4);
+    return cJSON_CreateIntArray((int*)&rng->s, 4);
 }
 
 void rand_deserialize(cJSON *r)
 {
+    rng_state *rng = rng_current();
+
     g_assert(r != NULL);
     g_assert(cJSON_GetArraySize(r) == 4);
 
@@ -116,17 +136,19 @@ void rand_deserialize(cJSON *r)
     {
         cJSON* it = cJSON_GetArrayItem(r, i);
         g_assert(cJSON_IsNumber(it));
-        s[i] = (guint64)it->valuedouble;
+        rng->s[i] = (guint64)it->valuedouble;
     }
 
-    seeded = TRUE;
+    rng->seeded = TRUE;
 }
 
 guint32 rand_0n(guint32 n)
 {
-    if (!seeded)
+    rng_state *rng = rng_current();
+
+    if (!rng->seeded)
     {
-        rand_seed();
+        rand_seed(rng);
     }
 
     guint32 min = -n % n;
@@ -139,10 +161,10 @@ guint32 rand_0n(guint32 n)
             return 0;
             break;
         case UINT32_MAX:
-            return next();
+            return next(rng->s);
             break;
         default:
-            while ((result = next()) < min);
+            while ((result = next(rng->s)) < min);
 
             return result % n;
             break;
@@ -163,6 +185,97 @@ int divert(int value, int percent)
     return rand_m_n(lower, upper);
 }
 
+rand_alias *rand_alias_new(const guint32 weights[], guint count)
+{
+    guint64 total = 0;
+
+    for (guint idx = 0; idx < count; idx++)
+        total += weights[idx];
+
+    if (total == 0)
+        return NULL;
+
+    g_assert(total < G_MAXUINT32);
+
+    rand_alias *ra = g_malloc(sizeof(rand_alias) + count * sizeof(ra->entries[0]));
+    ra->count = count;
+    ra->total = total;
+
+    /* The weights are multiplied by count to make their average equal to
+       total. Each entry gets a weight below the average, topped up to the
+       average by a part of an entry above the average. With integers, the
+       resulting probabilities are exact. */
+    guint64 *scaled = g_new(guint64, count);
+    guint *small = g_new(guint, count);
+    guint *large = g_new(guint, count);
+    guint nsmall = 0, nlarge = 0;
+
+    for (guint idx = 0; idx < count; idx++)
+    {
+        scaled[idx] = (guint64)weights[idx] * count;
+
+        if (scaled[idx] < total)
+            small[nsmall++] = idx;
+        else
+            large[nlarge++] = idx;
+    }
+
+    while (nsmall > 0 && nlarge > 0)
+    {
+        guint s = small[--nsmall];
+        guint l = large[--nlarge];
+
+        ra->entries[s].prob = scaled[s];
+        ra->entries[s].alias = l;
+
+        scaled[l] -= total - scaled[s];
+
+        if (scaled[l] < total)
+            small[nsmall++] = l;
+        else
+            large[nlarge++] = l;
+    }
+
+    while (nlarge > 0)
+    {
+        guint l = large[--nlarge];
+        ra->entries[l].prob = total;
+        ra->entries[l].alias = l;
+    }
+
+    /* not reached with exact arithmetic */
+    while (nsmall > 0)
+    {
+        guint s = small[--nsmall];
+        ra->entries[s].prob = total;
+        ra->entries[s].alias = s;
+    }
+
+    g_free(scaled);
+    g_free(small);
+    g_free(large);
+
+    return ra;
+}
+
+guint rand_alias_draw(rand_alias *ra)
+{
+    g_assert(ra != NULL);
+
+    guint idx = rand_0n(ra->count);
+
+    if (ra->entries[idx].prob == ra->total
+            || rand_0n(ra->total) < ra->entries[idx].prob)
+        return idx;
+
+    return ra->entries[idx].alias;
+}
+
+void rand_alias_destroy(rand_alias *ra)
+{
+    g_free(ra);
+}
+
 void shuffle(int array[], int length, int skip)
 {
     for (int i = 0; i < length; i++)
@@ -0,0 +1,269 @@
+/*
+ * replay.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "display.h"
+#include "extdefs.h"
+#include "game.h"
+#include "replay.h"
+
+/*
+ * File format: the magic bytes, followed by the format version, the seed,
+ * the difficulty, the wizard mode flag, name, gender, stats and auto-pickup
+ * settings, and finally the keys. All numbers are stored as variable length
+ * integers of 7 bits per byte, strings are stored as their length + 1 (0
+ * for none) followed by the characters.
+ */
+static const char replay_magic[4] = { 'N', 'L', 'R', 'P' };
+#define REPLAY_VERSION 1
+
+/* pause between two keys when watching a recording (ms) */
+#define REPLAY_KEY_DELAY 100
+
+typedef enum _replay_mode
+{
+    RM_NONE,
+    RM_RECORD,
+    RM_PLAY,
+} replay_mode;
+
+/* there is only one recording per process, see game.h */
+static replay_mode replay_state = RM_NONE;
+static FILE *replay_file = NULL;
+static guint32 replay_rng_seed = 0;
+
+/* fast-forward the played back game until this turn */
+static guint32 replay_turn = 0;
+static gboolean replay_fast = FALSE;
+
+static void replay_write_uint(guint32 val);
+static gboolean replay_read_uint(guint32 *val);
+static void replay_write_str(const char *str);
+static gboolean replay_read_str(char **str);
+
+gboolean replay_record_start(const char *filename, struct game_config *config)
+{
+    g_assert(replay_state == RM_NONE && filename != NULL && config != NULL);
+
+    if (!(replay_file = fopen(filename, "wb")))
+        return FALSE;
+
+    replay_state = RM_RECORD;
+    replay_rng_seed = g_random_int();
+
+    fwrite(replay_magic, sizeof(replay_magic), 1, replay_file);
+    replay_write_uint(REPLAY_VERSION);
+    replay_write_uint(replay_rng_seed);
+    replay_write_uint(config->difficulty);
+    replay_write_uint(config->wizard);
+    replay_write_str(config->name);
+    replay_write_str(config->gender);
+    replay_write_str(config->stats);
+    replay_write_str(config->auto_pickup);
+    fflush(replay_file);
+
+    return TRUE;
+}
+
+gboolean replay_play_start(const char *filename, struct game_config *config,
+                           guint32 turn)
+{
+    char magic[sizeof(replay_magic)];
+    guint32 version, difficulty, wizard;
+    char *name = NULL, *gender = NULL, *stats = NULL, *auto_pickup = NULL;
+
+    g_assert(replay_state == RM_NONE && filename != NULL && config != NULL);
+
+    if (!(replay_file = fopen(filename, "rb")))
+        return FALSE;
+
+    if (fread(magic, sizeof(magic), 1, replay_file) != 1
+            || memcmp(magic, replay_magic, sizeof(magic))
+            || !replay_read_uint(&version) || version != REPLAY_VERSION
+            || !replay_read_uint(&replay_rng_seed)
+            || !replay_read_uint(&difficulty)
+            || !replay_read_uint(&wizard)
+            || !replay_read_str(&name)
+            || !replay_read_str(&gender)
+            || !replay_read_str(&stats)
+            || !replay_read_str(&auto_pickup))
+    {
+        /* not a recording or a broken one */
+        g_free(name);
+        g_free(gender);
+        g_free(stats);
+        g_free(auto_pickup);
+        fclose(replay_file);
+        replay_file = NULL;
+
+        return FALSE;
+    }
+
+    /* the recorded game has to be played with the recorded settings */
+    g_free(config->name);
+    g_free(config->gender);
+    g_free(config->stats);
+    g_free(config->auto_pickup);
+
+    config->difficulty = difficulty;
+    config->wizard = wizard;
+    config->name = name;
+    config->gender = gender;
+    config->stats = stats;
+    config->auto_pickup = auto_pickup;
+
+    replay_state = RM_PLAY;
+    replay_turn = turn;
+
+    return TRUE;
+}
+
+void replay_stop()
+{
+    if (replay_state == RM_NONE)
+        return;
+
+    if (replay_fast)
+    {
+        replay_fast = FALSE;
+        display_suspend(FALSE);
+    }
+
+    fclose(replay_file);
+    replay_file = NULL;
+    replay_state = RM_NONE;
+}
+
+gboolean replay_active()
+{
+    return (replay_state != RM_NONE);
+}
+
+guint32 replay_seed()
+{
+    g_assert(replay_state != RM_NONE);
+
+    return replay_rng_seed;
+}
+
+gboolean replay_key_get(int *key)
+{
+    guint32 val;
+
+    if (replay_state != RM_PLAY)
+        return FALSE;
+
+    if (!replay_read_uint(&val))
+    {
+        /* the recording is exhausted, the player takes over */
+        replay_stop();
+        return FALSE;
+    }
+
+    /* don't show anything until the desired turn has been reached */
+    gboolean fast = (replay_turn > (nlarn ? game_turn(nlarn) : 0));
+
+    if (fast != replay_fast)
+    {
+        replay_fast = fast;
+        display_suspend(fast);
+    }
+
+    /* give spectators time to follow the game */
+    if (!fast)
+        display_delay(REPLAY_KEY_DELAY);
+
+    *key = (int)val;
+
+    return TRUE;
+}
+
+void replay_key_add(int key)
+{
+    if (replay_state != RM_RECORD || key < 0)
+        return;
+
+    replay_write_uint(key);
+
+    /* keep the recording usable if the game crashes */
+    fflush(replay_file);
+}
+
+static void replay_write_uint(guint32 val)
+{
+    while (val >= 0x80)
+    {
+        fputc((val & 0x7f) | 0x80, replay_file);
+        val >>= 7;
+    }
+
+    fputc(val, replay_file);
+}
+
+static gboolean replay_read_uint(guint32 *val)
+{
+    int c, shift = 0;
+
+    *val = 0;
+
+    do
+    {
+        if ((c = fgetc(replay_file)) == EOF || shift > 28)
+            return FALSE;
+
+        *val |= (guint32)(c & 0x7f) << shift;
+        shift += 7;
+    }
+    while (c & 0x80);
+
+    return TRUE;
+}
+
+static void replay_write_str(const char *str)
+{
+    if (str == NULL)
+    {
+        replay_write_uint(0);
+        return;
+    }
+
+    replay_write_uint(strlen(str) + 1);
+    fwrite(str, strlen(str), 1, replay_file);
+}
+
+static gboolean replay_read_str(char **str)
+{
+    guint32 len;
+
+    if (!replay_read_uint(&len))
+        return FALSE;
+
+    if (len-- == 0)
+    {
+        *str = NULL;
+        return TRUE;
+    }
+
+    *str = g_malloc0(len + 1);
+
+    return (len == 0 || fread(*str, len, 1, replay_file) == 1);
+}
@@ -149,8 +149,8 @@ item_usage_result scroll_read(struct player *p, item *r_scroll)
 
     if (r_scroll->cursed)
     {
-        damage *dam = damage_new(DAM_FIRE, ATT_NONE, rand_1n(p->hp),
-                                 DAMO_ITEM, NULL);
+        damage dam = damage_new(DAM_FIRE, ATT_NONE, rand_1n(p->hp),
+                                DAMO_ITEM, NULL);
 
         log_add_entry(nlarn->log, "The scroll explodes!");
         player_damage_take(p, dam, PD_CURSE, r_scroll->type);
@@ -296,19 +296,19 @@ static int scroll_annihilate(struct player *p, item *r_scroll __attribute__((unu
     g_assert(p != NULL);
 
     int count = 0;
-    area *blast, *obsmap;
+    area blast, obsmap;
     position cursor = p->pos;
     monster *m;
     map *cmap = game_map(nlarn, Z(p->pos));
 
-    obsmap = map_get_obstacles(cmap, p->pos, 2, FALSE);
-    blast = area_new_circle_flooded(p->pos, 2, obsmap);
+    map_get_obstacles(cmap, p->pos, 2, FALSE, &obsmap);
+    area_init_circle_flooded(&blast, p->pos, 2, &obsmap);
 
-    for (Y(cursor) = blast->start_y; Y(cursor) < blast->start_y + blast->size_y; Y(cursor)++)
+    for (Y(cursor) = blast.start_y; Y(cursor) < blast.start_y + blast.size_y; Y(cursor)++)
     {
-        for (X(cursor) = blast->start_x; X(cursor) < blast->start_x + blast->size_x; X(cursor)++)
+        for (X(cursor) = blast.start_x; X(cursor) < blast.start_x + blast.size_x; X(cursor)++)
         {
-            if (area_pos_get(blast, cursor) && (m = map_get_monster_at(cmap, cursor)))
+            if (area_pos_get(&blast, cursor) && (m = map_get_monster_at(cmap, cursor)))
             {
                 if (monster_flags(m, DEMON))
                 {
@@ -324,8 +324,8 @@ static int scroll_annihilate(struct player *p, item *r_scroll __attribute__((unu
                                   monster_get_name(m));
 
                     /* lose half hit points */
-                    damage *dam = damage_new(DAM_MAGICAL, ATT_NONE, monster_hp(m) / 2,
-                                             DAMO_PLAYER, p);
+                    damage dam = damage_new(DAM_MAGICAL, ATT_NONE, monster_hp(m) / 2,
+                                            DAMO_PLAYER, p);
 
                     monster_damage_take(m, dam);
                 }
@@ -333,8 +333,6 @@ static int scroll_annihilate(struct player *p, item *r_scroll __attribute__((unu
         }
     }
 
-    area_destroy(blast);
-
     if (count)
     {
         log_add_entry(nlarn->log, "You hear loud screams of agony!");
@@ -433,6 +431,8 @@ static int scroll_enchant_armour(player *p, item *r_scroll)
             (*armour)->rusty = FALSE;
             (*armour)->burnt = FALSE;
             (*armour)->corroded = FALSE;
+            player_modifiers_invalidate(p);
+
             if ((*armour)->bonus < 0)
             {
                 (*armour)->bonus = 0;
@@ -518,6 +518,7 @@ static int scroll_gem_perfection(player *p, item *r_scroll)
             /* double gem value */
             it->bonus <<= 1;
         }
+        inv_items_changed();
         log_add_entry(nlarn->log, "You bring all your gems to perfection.");
     }
     else
@@ -532,6 +533,7 @@ static int scroll_gem_perfection(player *p, item *r_scroll)
 
             /* double gem value */
             it->bonus <<= 1;
+            inv_items_changed();
         }
     }
 
@@ -643,37 +645,25 @@ static int scroll_genocide_monster(player *p, item *r_scroll)
 
 static int scroll_heal_monster(player *p, item *r_scroll __attribute__((unused)))
 {
-    GList *mlist;
     int count = 0;
 
     g_assert(p != NULL);
 
-    mlist = g_hash_table_get_values(nlarn->monsters);
-
-    do
+    /* heal the monsters on the same level */
+    for (monster *m = game_map(nlarn, Z(p->pos))->mfirst; m; m = monster_map_next(m))
     {
-        monster *m = (monster *)mlist->data;
-        position mpos = monster_pos(m);
-
-        /* find monsters on the same level */
-        if (Z(mpos) == Z(p->pos))
+        if (monster_hp(m) < monster_hp_max(m))
         {
-            if (monster_hp(m) < monster_hp_max(m))
-            {
-                monster_hp_inc(m, monster_hp_max(m));
-                count++;
-            }
+            monster_hp_inc(m, monster_hp_max(m));
+            count++;
         }
     }
-    while ((mlist = mlist->next));
 
     if (count > 0)
     {
         log_add_entry(nlarn->log, "You feel uneasy.");
     }
 
-    g_list_free(mlist);
-
     return count;
 }
 
@@ -681,20 +671,20 @@ static int scroll_hold_monster(player *p, item *r_scroll __attribute__((unused))
 {
     g_assert(p != NULL);
 
-    area *blast, *obsmap;
+    area blast, obsmap;
     position cursor = p->pos;
     monster *m;
     gboolean success = FALSE;
     map *cmap = game_map(nlarn, Z(p->pos));
 
-    obsmap = map_get_obstacles(cmap, p->pos, 2, FALSE);
-    blast = area_new_circle_flooded(p->pos, 2, obsmap);
+    map_get_obstacles(cmap, p->pos, 2, FALSE, &obsmap);
+    area_init_circle_flooded(&blast, p->pos, 2, &obsmap);
 
-    for (Y(cursor) = blast->start_y; Y(cursor) < blast->start_y + blast->size_y; Y(cursor)++)
+    for (Y(cursor) = blast.start_y; Y(cursor) < blast.start_y + blast.size_y; Y(cursor)++)
     {
-        for (X(cursor) = blast->start_x; X(cursor) < blast->start_x + blast->size_x; X(cursor)++)
+        for (X(cursor) = blast.start_x; X(cursor) < blast.start_x + blast.size_x; X(cursor)++)
         {
-            if (area_pos_get(blast, cursor) && (m = map_get_monster_at(cmap, cursor)))
+            if (area_pos_get(&blast, cursor) && (m = map_get_monster_at(cmap, cursor)))
             {
                 effect *e = effect_new(ET_HOLD_MONSTER);
                 monster_effect_add(m, e);
@@ -703,7 +693,6 @@ static int scroll_hold_monster(player *p, item *r_scroll __attribute__((unused))
             }
         }
     }
-    area_destroy(blast);
 
     return success;
 }
@@ -988,6 +977,18 @@ static int scroll_timewarp(player *p, item *r_scroll)
             continue;
         }
 
+        if (!effect_type_countdown(e->type))
+        {
+            /* the duration of the effect is counted from its start,
+               thus only effects that are no longer valid are affected */
+            if (effect_turns_left(e) <= 0 || e->start > game_turn(nlarn))
+                player_effect_del(p, e);
+            else
+                idx++;
+
+            continue;
+        }
+
         if (turns > 0)
         {
             /* gone forward in time */
@@ -696,9 +696,9 @@ int player_fountain_wash(player *p)
     {
         log_add_entry(nlarn->log, "Oh no! The water was foul!");
 
-        damage *dam = damage_new(DAM_POISON, ATT_NONE,
-                                 rand_1n((Z(p->pos) << 2) + 2),
-                                 DAMO_SOBJECT, NULL);
+        damage dam = damage_new(DAM_POISON, ATT_NONE,
+                                rand_1n((Z(p->pos) << 2) + 2),
+                                DAMO_SOBJECT, NULL);
 
         player_damage_take(p, dam, PD_SOBJECT, LS_FOUNTAIN);
 
@@ -806,9 +806,9 @@ int player_stairs_down(player *p)
         if (bval > 0)
         {
             log_add_entry(nlarn->log, "You slip!");
-            damage *dam = damage_new(DAM_PHYSICAL, ATT_NONE,
-                                     rand_1n(bval + nlevel->nlevel),
-                                     DAMO_SOBJECT, NULL);
+            damage dam = damage_new(DAM_PHYSICAL, ATT_NONE,
+                                    rand_1n(bval + nlevel->nlevel),
+                                    DAMO_SOBJECT, NULL);
 
             player_damage_take(p, dam, PD_SOBJECT, ms);
         }
@@ -996,12 +996,11 @@ void sobject_destroy_at(player *p, map *dmap, position pos)
 
         /* flood the area surrounding the altar with lightning */
         damage_originator damo = { DAMO_GOD, NULL };
-        damage *dam = damage_new(DAM_ELECTRICITY, ATT_MAGIC,
-                                 25 + p->level + rand_0n(25 + p->level),
-                                 damo.ot, damo.originator);
+        damage dam = damage_new(DAM_ELECTRICITY, ATT_MAGIC,
+                                25 + p->level + rand_0n(25 + p->level),
+                                damo.ot, damo.originator);
 
-        area_blast(pos, 3, &damo, sobject_blast_hit, dam, NULL, '*', LIGHTCYAN);
-        damage_free(dam);
+        area_blast(pos, 3, &damo, sobject_blast_hit, &dam, NULL, '*', LIGHTCYAN);
 
         break;
     }
@@ -1089,11 +1088,12 @@ static void monster_appear(monster_t type, position mpos)
 
 static void flood_affect_area(position pos, int radius, int type, int duration)
 {
-    area *obstacles = map_get_obstacles(game_map(nlarn, Z(pos)), pos, radius, FALSE);
-    area *range = area_new_circle_flooded(pos, radius, obstacles);
+    area obstacles, range;
 
-    map_set_tiletype(game_map(nlarn, Z(pos)), range, type, duration);
-    area_destroy(range);
+    map_get_obstacles(game_map(nlarn, Z(pos)), pos, radius, FALSE, &obstacles);
+    area_init_circle_flooded(&range, pos, radius, &obstacles);
+
+    map_set_tiletype(game_map(nlarn, Z(pos)), &range, type, duration);
 }
 
 static gboolean sobject_blast_hit(position pos,
@@ -1119,7 +1119,7 @@ static gboolean sobject_blast_hit(position pos,
             log_add_entry(nlarn->log, "The lightning hits the %s.",
                           monster_get_name(m));
 
-        monster_damage_take(m, damage_copy(dam));
+        monster_damage_take(m, *dam);
 
         return TRUE;
     }
@@ -1157,7 +1157,7 @@ static gboolean sobject_blast_hit(position pos,
         log_add_entry(nlarn->log, "The lightning hits you!");
         /* FIXME: correctly state that the player has been killed by the
                   wrath of a god */
-        player_damage_take(nlarn->p, damage_copy(dam), PD_SPELL, SP_LIT);
+        player_damage_take(nlarn->p, *dam, PD_SPELL, SP_LIT);
 
         /* hit */
         return TRUE;
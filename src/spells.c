@@ -362,9 +362,6 @@ book_obfuscation[SP_MAX] =
 */
 };
 
-/* the last cast spell */
-static spell *last_spell = NULL;
-
 /* local functions */
 static int spell_cast(player *p, spell *s);
 static void spell_print_success_message(spell *s, monster *m);
@@ -373,7 +370,7 @@ static int count_adjacent_water_squares(position pos);
 static int try_drying_ground(position pos);
 
 /* simple wrapper for spell_area_pos_hit() */
-static gboolean spell_traj_pos_hit(const GList *traj,
+static gboolean spell_traj_pos_hit(const position_span *traj, guint idx,
         const damage_originator *damo,
         gpointer data1, gpointer data2);
 
@@ -492,13 +489,13 @@ int spell_cast_new(struct player *p)
     }
 
     /* show spell selection dialogue */
-    last_spell = display_spell_select("Select a spell to cast", p);
+    p->last_spell = display_spell_select("Select a spell to cast", p);
 
     /* player aborted spell selection by pressing ESC */
-    if (!last_spell)
+    if (!p->last_spell)
         return 0;
 
-    return spell_cast(p, last_spell);
+    return spell_cast(p, p->last_spell);
 }
 
 int spell_cast_previous(struct player *p)
@@ -511,12 +508,12 @@ int spell_cast_previous(struct player *p)
     }
 
     /* not casted any spell before */
-    if (!last_spell)
+    if (!p->last_spell)
     {
         return spell_cast_new(p);
     }
 
-    return spell_cast(p, last_spell);
+    return spell_cast(p, p->last_spell);
 }
 
 int spell_learn(player *p, spell_id spell_type)
@@ -630,6 +627,8 @@ static gboolean spell_type_player(spell *s, struct player *p)
             if (e->amount < (effect_type_amount(e->type) * (int)s->knowledge))
             {
                 e->amount += effect_type_amount(e->type);
+                effect_summary_update(&p->esummary, p->effects, e->type);
+                player_modifiers_invalidate(p);
                 log_add_entry(nlarn->log, "You have extended the power of %s.",
                         spell_name(s));
 
@@ -655,10 +654,11 @@ static gboolean spell_type_player(spell *s, struct player *p)
             /* The duration of this effect can be incremented.
              * Increase the duration of the effect up to the base
              * effect duration * spell knowledge value. */
-            if (e->turns + effect_type_duration(e->type)
+            if (effect_turns_left(e) + effect_type_duration(e->type)
                 < (effect_type_duration(e->type) * s->knowledge))
             {
                 e->turns += effect_type_duration(e->type);
+                effect_schedule(e, NULL);
                 log_add_entry(nlarn->log, "You have extended the duration "
                         "of %s.", spell_name(s));
             }
@@ -886,26 +886,26 @@ static gboolean spell_type_ray(spell *s, struct player *p)
     }
 
     damage_originator damo = { DAMO_PLAYER, p };
-    damage *dam = damage_new(spells[s->id].damage_type, ATT_MAGIC, 0,
-                             damo.ot, damo.originator);
+    damage dam = damage_new(spells[s->id].damage_type, ATT_MAGIC, 0,
+                            damo.ot, damo.originator);
 
     /* determine amount of damage */
     switch (s->id)
     {
     case SP_MLE:
-        dam->amount = (1 + rand_1n(5)) * s->knowledge + p->level;
+        dam.amount = (1 + rand_1n(5)) * s->knowledge + p->level;
         break;
 
     case SP_SSP:
-        dam->amount = (2 + rand_1n(10)) * s->knowledge + p->level;
+        dam.amount = (2 + rand_1n(10)) * s->knowledge + p->level;
         break;
 
     case SP_CLD:
-        dam->amount = (3 + rand_1n(15)) * s->knowledge + p->level;
+        dam.amount = (3 + rand_1n(15)) * s->knowledge + p->level;
         break;
 
     case SP_LIT:
-        dam->amount = (4 + rand_1n(20)) * s->knowledge + p->level;
+        dam.amount = (4 + rand_1n(20)) * s->knowledge + p->level;
         break;
     default:
         /* this shouldn't happen */
@@ -914,11 +914,7 @@ static gboolean spell_type_ray(spell *s, struct player *p)
 
     /* throw a ray to the selected target */
     map_trajectory(p->pos, target, &damo, spell_traj_pos_hit,
-                   s, dam, TRUE, '*', spell_colour(s), TRUE);
-
-    /* The callback functions give a copy of the damage to the specific
-       functions, thus the original has to be destroyed here. */
-    damage_free(dam);
+                   s, &dam, TRUE, '*', spell_colour(s), TRUE);
 
     return TRUE;
 }
@@ -968,20 +964,20 @@ static gboolean spell_type_flood(spell *s, struct player *p)
         break;
     }
 
-    area *obstacles = map_get_obstacles(game_map(nlarn, Z(pos)), pos, radius, FALSE);
-    area *range = area_new_circle_flooded(pos, radius, obstacles);
+    area obstacles, range;
 
-    if (area_pos_get(range, p->pos)
+    map_get_obstacles(game_map(nlarn, Z(pos)), pos, radius, FALSE, &obstacles);
+    area_init_circle_flooded(&range, pos, radius, &obstacles);
+
+    if (area_pos_get(&range, p->pos)
             && !display_get_yesno("The spell is going to hit you. " \
                                   "Cast anyway?", NULL, NULL, NULL))
     {
         log_add_entry(nlarn->log, "Aborted.");
-        area_destroy(range);
         return FALSE;
     }
 
-    map_set_tiletype(game_map(nlarn, Z(pos)), range, type, amount);
-    area_destroy(range);
+    map_set_tiletype(game_map(nlarn, Z(pos)), &range, type, amount);
 
     return TRUE;
 }
@@ -990,7 +986,7 @@ static gboolean spell_type_blast(spell *s, struct player *p)
 {
     g_assert(s != NULL && p != NULL && (spell_type(s) == SC_BLAST));
 
-    area *ball;
+    area ball, obstacles;
     position pos;
     char buffer[61];
     int amount = 0;
@@ -1021,11 +1017,10 @@ static gboolean spell_type_blast(spell *s, struct player *p)
     }
 
     /* get the affected area to determine if the player would be hit */
-    ball = area_new_circle_flooded(pos, radius, map_get_obstacles(cmap, pos,
-                radius, TRUE));
+    map_get_obstacles(cmap, pos, radius, TRUE, &obstacles);
+    area_init_circle_flooded(&ball, pos, radius, &obstacles);
 
-    gboolean player_affected = area_pos_get(ball, p->pos);
-    area_destroy(ball);
+    gboolean player_affected = area_pos_get(&ball, p->pos);
 
     if (player_affected
         && !display_get_yesno("The spell is going to hit you. Cast anyway?", NULL, NULL, NULL))
@@ -1034,12 +1029,9 @@ static gboolean spell_type_blast(spell *s, struct player *p)
         return FALSE;
     }
 
-    damage *dam = damage_new(spells[s->id].damage_type, ATT_MAGIC,
-                             amount, DAMO_PLAYER, p);
-    area_blast(pos, radius, &damo, spell_area_pos_hit, s, dam, '*', spell_colour(s));
-
-    /* destroy the damage as the callbacks deliver a copy */
-    damage_free(dam);
+    damage dam = damage_new(spells[s->id].damage_type, ATT_MAGIC,
+                            amount, DAMO_PLAYER, p);
+    area_blast(pos, radius, &damo, spell_area_pos_hit, s, &dam, '*', spell_colour(s));
 
     return TRUE;
 }
@@ -1209,13 +1201,14 @@ static gboolean spell_scare_monsters(spell *s, struct player *p)
 
     /* the radius of this spell is determined by the player's level of
        spell knowledge */
-    area *a = area_new_circle(p->pos, 1 + s->knowledge, FALSE);
+    area a;
+    area_init_circle(&a, p->pos, 1 + s->knowledge, FALSE);
 
-    for (int y = a->start_y; y < a->start_y + a->size_y; y++)
+    for (int y = a.start_y; y < a.start_y + a.size_y; y++)
     {
         Y(pos) = y;
 
-        for (int x = a->start_x; x < a->start_x + a->size_x; x++)
+        for (int x = a.start_x; x < a.start_x + a.size_x; x++)
         {
             X(pos) = x;
 
@@ -1239,9 +1232,6 @@ static gboolean spell_scare_monsters(spell *s, struct player *p)
         }
     }
 
-    /* free allocated memory */
-    area_destroy(a);
-
     return (count > 0);
 }
 
@@ -1314,7 +1304,7 @@ static gboolean spell_make_wall(spell *s __attribute__((unused)), player *p)
                 {
                     /* briefly display the new monster before it dies */
                     display_paint_screen(nlarn->p);
-                    g_usleep(250000);
+                    display_delay(250);
 
                     log_add_entry(nlarn->log, "The %s is trapped in the wall!",
                                   monster_get_name(m));
@@ -1632,14 +1622,11 @@ static int try_drying_ground(position pos)
     return FALSE;
 }
 
-static gboolean spell_traj_pos_hit(const GList *traj,
+static gboolean spell_traj_pos_hit(const position_span *traj, guint idx,
         const damage_originator *damo,
         gpointer data1, gpointer data2)
 {
-    position pos;
-    pos_val(pos) = GPOINTER_TO_UINT(traj->data);
-
-    return spell_area_pos_hit(pos, damo, data1, data2);
+    return spell_area_pos_hit(traj->pos[idx], damo, data1, data2);
 }
 
 static gboolean spell_area_pos_hit(position pos,
@@ -1703,7 +1690,7 @@ static gboolean spell_area_pos_hit(position pos,
         if (iet > IET_NONE)
             inv_erode(monster_inv(m), iet, FALSE, NULL);
 
-        monster_damage_take(m, damage_copy(dam));
+        monster_damage_take(m, *dam);
 
         /*
          * If the monster is at least of human size, the spell stops at
@@ -1756,7 +1743,7 @@ static gboolean spell_area_pos_hit(position pos,
             else
             {
                 log_add_entry(nlarn->log, "The %s hits you!", spell_name(sp));
-                player_damage_take(nlarn->p, damage_copy(dam), PD_SPELL, sp->id);
+                player_damage_take(nlarn->p, *dam, PD_SPELL, sp->id);
 
                 /* erode the player's inventory */
                 if (iet > IET_NONE)
@@ -0,0 +1,196 @@
+/*
+ * timewheel.c
+ * Copyright (C) 2009-2020 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "timewheel.h"
+
+/* Every level of the wheel has 64 slots. The slots of the first level
+   cover one turn each, the slots of each following level cover all
+   slots of the preceding level. Four levels cover 2^24 turns. */
+#define TW_BITS   6
+#define TW_SIZE   (1 << TW_BITS)
+#define TW_MASK   (TW_SIZE - 1)
+#define TW_LEVELS 4
+#define TW_RANGE  (1u << (TW_BITS * TW_LEVELS))
+
+struct _timewheel
+{
+    guint32 next;                       /* the next game turn to process */
+    GArray *slots[TW_LEVELS][TW_SIZE];  /* pending timers */
+};
+
+static void timewheel_insert(timewheel *tw, const timewheel_entry *entry);
+static GArray *timewheel_slot_take(timewheel *tw, int level, int idx);
+static int timewheel_cascade(timewheel *tw, int level);
+static void timewheel_rewind(timewheel *tw, guint32 next);
+
+timewheel *timewheel_new(guint32 now)
+{
+    timewheel *tw = g_malloc0(sizeof(timewheel));
+    tw->next = now + 1;
+
+    return tw;
+}
+
+void timewheel_destroy(timewheel *tw)
+{
+    g_assert(tw != NULL);
+
+    for (int level = 0; level < TW_LEVELS; level++)
+        for (int idx = 0; idx < TW_SIZE; idx++)
+        {
+            if (tw->slots[level][idx] != NULL)
+                g_array_free(tw->slots[level][idx], TRUE);
+        }
+
+    g_free(tw);
+}
+
+void timewheel_add(timewheel *tw, guint32 when, guint32 kind,
+                   gpointer data1, gpointer data2)
+{
+    timewheel_entry entry = { when, kind, data1, data2 };
+
+    g_assert(tw != NULL);
+
+    timewheel_insert(tw, &entry);
+}
+
+void timewheel_advance(timewheel *tw, guint32 now,
+                       timewheel_func func, gpointer data)
+{
+    g_assert(tw != NULL && func != NULL);
+
+    /* the game time has been turned back */
+    if (now + 1 < tw->next)
+        timewheel_rewind(tw, now + 1);
+
+    while (tw->next <= now)
+    {
+        const int idx = tw->next & TW_MASK;
+
+        /* refill the first level from the higher levels when it wraps */
+        if (idx == 0)
+        {
+            for (int level = 1; level < TW_LEVELS; level++)
+            {
+                if (timewheel_cascade(tw, level) != 0)
+                    break;
+            }
+        }
+
+        GArray *due = timewheel_slot_take(tw, 0, idx);
+        tw->next++;
+
+        if (due == NULL)
+            continue;
+
+        for (guint pos = 0; pos < due->len; pos++)
+        {
+            timewheel_entry *entry = &g_array_index(due, timewheel_entry, pos);
+
+            if (entry->when < tw->next)
+                func(entry, data);
+            else
+                /* timer was too far in the future to be placed exactly */
+                timewheel_insert(tw, entry);
+        }
+
+        g_array_free(due, TRUE);
+    }
+}
+
+static void timewheel_insert(timewheel *tw, const timewheel_entry *entry)
+{
+    guint32 when = entry->when;
+    int level, idx;
+
+    if (when < tw->next)
+    {
+        /* already due: process it with the next turn */
+        when = tw->next;
+    }
+    else if (when - tw->next >= TW_RANGE)
+    {
+        /* out of range: park it in the farthest slot */
+        when = tw->next + TW_RANGE - 1;
+    }
+
+    for (level = 0; level < TW_LEVELS - 1; level++)
+    {
+        if (when - tw->next < (1u << (TW_BITS * (level + 1))))
+            break;
+    }
+
+    idx = (when >> (TW_BITS * level)) & TW_MASK;
+
+    if (tw->slots[level][idx] == NULL)
+        tw->slots[level][idx] = g_array_new(FALSE, FALSE, sizeof(timewheel_entry));
+
+    g_array_append_val(tw->slots[level][idx], *entry);
+}
+
+static GArray *timewheel_slot_take(timewheel *tw, int level, int idx)
+{
+    GArray *slot = tw->slots[level][idx];
+    tw->slots[level][idx] = NULL;
+
+    return slot;
+}
+
+static int timewheel_cascade(timewheel *tw, int level)
+{
+    const int idx = (tw->next >> (TW_BITS * level)) & TW_MASK;
+    GArray *slot = timewheel_slot_take(tw, level, idx);
+
+    if (slot != NULL)
+    {
+        /* distribute the timers to the lower levels */
+        for (guint pos = 0; pos < slot->len; pos++)
+            timewheel_insert(tw, &g_array_index(slot, timewheel_entry, pos));
+
+        g_array_free(slot, TRUE);
+    }
+
+    return idx;
+}
+
+static void timewheel_rewind(timewheel *tw, guint32 next)
+{
+    GArray *pending = g_array_new(FALSE, FALSE, sizeof(timewheel_entry));
+
+    for (int level = 0; level < TW_LEVELS; level++)
+        for (int idx = 0; idx < TW_SIZE; idx++)
+        {
+            GArray *slot = timewheel_slot_take(tw, level, idx);
+
+            if (slot == NULL)
+                continue;
+
+            g_array_append_vals(pending, slot->data, slot->len);
+            g_array_free(slot, TRUE);
+        }
+
+    tw->next = next;
+
+    for (guint pos = 0; pos < pending->len; pos++)
+        timewheel_insert(tw, &g_array_index(pending, timewheel_entry, pos));
+
+    g_array_free(pending, TRUE);
+}
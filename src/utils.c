@@ -22,11 +22,33 @@
 #include <string.h>
 
 #include "extdefs.h"
+#include "profile.h"
 #include "utils.h"
 
-static const guint LOG_MAX_LENGTH = 100;
-
-static void log_entry_destroy(message_log_entry *entry);
+/* the usual size of the chunks holding the message log's entries */
+static const gsize LOG_CHUNK_SIZE = 4096;
+
+/* the longest conversion specification supported in log messages */
+#define LOG_SPEC_MAX 16
+
+/* format strings which can not be packed are stored as text with this */
+#define LOG_TEXT_TEMPLATE 0
+
+static void log_pack(message_log *log, const char *fmt, va_list argp);
+static gboolean log_pending_equal(message_log *log, guint first, guint second);
+static guint log_template_id(message_log *log, const char *fmt);
+static const char *log_conversion(const char *fmt, char *spec, char *conv);
+static void log_format(message_log *log, GString *out,
+                       const guint8 *data, gsize size);
+static cJSON *log_messages_serialize(message_log *log,
+                                     const guint8 *data, gsize size);
+static gboolean log_messages_deserialize(message_log *log, cJSON *mser,
+                                         GByteArray *dest, guint *last);
+static void log_entry_add(message_log *log, guint32 gtime,
+                          const guint8 *data, gsize size);
+static void log_entry_remove(message_log *log);
+static message_log_chunk *log_chunk_new(gsize size);
+static void log_chunk_free(message_log_chunk *chunk);
 
 char *str_capitalize(char *string)
 {
@@ -51,11 +73,16 @@ message_log *log_new()
     message_log *log;
 
     log = g_malloc0(sizeof(message_log));
+    profile_alloc(PM_MESSAGE_LOG, sizeof(message_log));
 
     log->active = TRUE;
+    log->pending = g_byte_array_new();
     log->buffer = g_string_new(NULL);
-    log->entries = g_ptr_array_new_with_free_func(
-            (GDestroyNotify)log_entry_destroy);
+    log->text = g_string_new(NULL);
+
+    log->templates = g_ptr_array_new_with_free_func(g_free);
+    log->template_ids = g_hash_table_new(g_str_hash, g_str_equal);
+    log_template_id(log, "%s");
 
     return log;
 }
@@ -64,58 +91,59 @@ void log_destroy(message_log *log)
 {
     g_assert(log != NULL);
 
-    g_ptr_array_free(log->entries, TRUE);
+    while (log->head != NULL)
+    {
+        message_log_chunk *chunk = log->head;
+        log->head = chunk->next;
+        log_chunk_free(chunk);
+    }
+
+    if (log->spare != NULL)
+    {
+        log_chunk_free(log->spare);
+    }
 
-    if (log->lastmsg != NULL)
+    for (guint idx = 0; idx < log->templates->len; idx++)
     {
-        g_free(log->lastmsg);
+        profile_free(PM_MESSAGE_LOG,
+                     strlen(g_ptr_array_index(log->templates, idx)) + 1);
     }
 
+    /* the keys of template_ids are owned by templates */
+    g_hash_table_destroy(log->template_ids);
+    g_ptr_array_free(log->templates, TRUE);
+
+    g_byte_array_free(log->pending, TRUE);
     g_string_free(log->buffer, TRUE);
+    g_string_free(log->text, TRUE);
+    profile_free(PM_MESSAGE_LOG, sizeof(message_log));
     g_free(log);
 }
 
 int log_add_entry(message_log *log, const char *fmt, ...)
 {
     va_list argp;
-    gchar *msg;
 
     if (log == NULL || log->active == FALSE)
         return FALSE;
 
-    /* assemble message and append it to the buffer */
+    /* pack the message and append it to the pending messages */
+    guint start = log->pending->len;
+
     va_start(argp, fmt);
-    msg = g_strdup_vprintf(fmt, argp);
+    log_pack(log, fmt, argp);
     va_end(argp);
 
-    /* compare new message to previous messages to avoid duplicates */
-    if (log->lastmsg)
-    {
-        if (g_strcmp0(msg, log->lastmsg) == 0)
-        {
-            /* message is equal to previous message */
-            g_free(msg);
-            return FALSE;
-        }
-        else
-        {
-            /* msg is not equal to previous message */
-            g_free(log->lastmsg);
-            log->lastmsg = msg;
-        }
-    }
-    else
-    {
-        log->lastmsg = msg;
-    }
-
-    /* if there is already text in the buffer, append a space first */
-    if (log->buffer->len)
+    /* compare new message to previous message to avoid duplicates */
+    if (start > 0 && log_pending_equal(log, log->lastmsg, start))
     {
-        g_string_append_c(log->buffer, ' ');
+        /* message is equal to previous message */
+        g_byte_array_set_size(log->pending, start);
+        return FALSE;
     }
 
-    g_string_append(log->buffer, msg);
+    log->lastmsg = start;
+    log->buffer_valid = FALSE;
 
     return TRUE;
 }
@@ -126,32 +154,15 @@ void log_set_time(message_log *log, int gtime)
     g_assert(log != NULL);
 
     /* flush pending entry */
-    if ((log->buffer)->len)
+    if (log->pending->len)
     {
-        message_log_entry *entry = g_malloc(sizeof(message_log_entry));
-        entry->gtime = log->gtime;
-        entry->message = (log->buffer)->str;
-
         /* append the entry to the message log */
-        g_ptr_array_add(log->entries, entry);
+        log_entry_add(log, log->gtime, log->pending->data, log->pending->len);
 
-        /* destroy buffer and add prepare new one */
-        g_string_free(log->buffer, FALSE);
-        log->buffer = g_string_new(NULL);
-    }
-
-    /* clean up previous message buffer */
-    if (log->lastmsg)
-    {
-        g_free(log->lastmsg);
-        log->lastmsg = NULL;
-    }
-
-    /* assure the log does not grow too much */
-    while (log_length(log) > LOG_MAX_LENGTH)
-    {
-        /* remove the first entry */
-        g_ptr_array_remove_index(log->entries, 0);
+        /* empty the buffer for the next turn */
+        g_byte_array_set_size(log->pending, 0);
+        log->lastmsg = 0;
+        log->buffer_valid = FALSE;
     }
 
     log->gtime = gtime;
@@ -160,7 +171,33 @@ void log_set_time(message_log *log, int gtime)
 message_log_entry *log_get_entry(message_log *log, guint id)
 {
     g_assert(log != NULL && id < log_length(log));
-    return g_ptr_array_index(log->entries, id);
+    return &log->entries[(log->first + id) % LOG_MAX_LENGTH];
+}
+
+const char *log_entry_text(message_log *log, message_log_entry *entry)
+{
+    g_assert(log != NULL && entry != NULL);
+
+    g_string_truncate(log->text, 0);
+    log_format(log, log->text, entry->data, entry->size);
+
+    return log->text->str;
+}
+
+const char *log_buffer(message_log *log)
+{
+    if (log->pending->len == 0)
+        return NULL;
+
+    /* the status line asks for the text every time it is painted */
+    if (!log->buffer_valid)
+    {
+        g_string_truncate(log->buffer, 0);
+        log_format(log, log->buffer, log->pending->data, log->pending->len);
+        log->buffer_valid = TRUE;
+    }
+
+    return log->buffer->str;
 }
 
 cJSON *log_serialize(message_log *log)
@@ -168,6 +205,17 @@ cJSON *log_serialize(message_log *log)
     cJSON *log_ser = cJSON_CreateObject();
     cJSON *log_entries = cJSON_CreateArray();
 
+    /* the format strings are stored only once */
+    cJSON *templates = cJSON_CreateArray();
+
+    for (guint idx = 0; idx < log->templates->len; idx++)
+    {
+        cJSON_AddItemToArray(templates, cJSON_CreateString(
+                                 g_ptr_array_index(log->templates, idx)));
+    }
+
+    cJSON_AddItemToObject(log_ser, "templates", templates);
+
     /* create array of log entries */
     for (guint idx = 0; idx < log_length(log); idx++)
     {
@@ -176,19 +224,16 @@ cJSON *log_serialize(message_log *log)
 
         cJSON_AddItemToArray(log_entries, log_entry);
         cJSON_AddNumberToObject(log_entry, "gtime", entry->gtime);
-        cJSON_AddStringToObject(log_entry, "message", entry->message);
+        cJSON_AddItemToObject(log_entry, "messages",
+                              log_messages_serialize(log, entry->data, entry->size));
     }
 
-    /* add this turns message if filled */
-    if (log->buffer->len > 0)
+    /* add this turns messages if filled */
+    if (log->pending->len > 0)
     {
-        cJSON_AddStringToObject(log_ser, "buffer", log->buffer->str);
-    }
-
-    /* add last message buffer if filled */
-    if (log->lastmsg != NULL)
-    {
-        cJSON_AddStringToObject(log_ser, "lastmsg", log->lastmsg);
+        cJSON_AddItemToObject(log_ser, "pending",
+                              log_messages_serialize(log, log->pending->data,
+                                                     log->pending->len));
     }
 
     /* add array of entries to log object */
@@ -202,44 +247,46 @@ message_log *log_deserialize(cJSON *lser)
     cJSON *obj;
 
     /* create new message log */
-    message_log *log = g_malloc0(sizeof(message_log));
-
-    log->active = TRUE;
-    log->entries = g_ptr_array_new_with_free_func(
-            (GDestroyNotify)log_entry_destroy);
+    message_log *log = log_new();
 
-    /* try to restore this turns message */
-    if ((obj = cJSON_GetObjectItem(lser, "buffer")) != NULL)
+    /* restore the format strings in their original order */
+    if ((obj = cJSON_GetObjectItem(lser, "templates")) != NULL)
     {
-        /* restore buffer from saved value */
-        log->buffer = g_string_new(obj->valuestring);
-    }
-    else
-    {
-        /* create empty buffer */
-        log->buffer = g_string_new(NULL);
+        for (int idx = 0; idx < cJSON_GetArraySize(obj); idx++)
+        {
+            guint id = log_template_id(log, cJSON_GetArrayItem(obj, idx)->valuestring);
+            g_assert(id == (guint)idx);
+        }
     }
 
-    /* try to restore the last message */
-    if ((obj = cJSON_GetObjectItem(lser, "lastmsg")) != NULL)
+    /* try to restore this turns messages */
+    if ((obj = cJSON_GetObjectItem(lser, "pending")) != NULL)
     {
-        log->lastmsg = g_strdup(obj->valuestring);
+        log_messages_deserialize(log, obj, log->pending, &log->lastmsg);
     }
 
     /* try to get all log entries from the supplied cJSON object */
     if ((obj = cJSON_GetObjectItem(lser, "entries")) != NULL)
     {
-    /* reconstruct message log entries */
+        GByteArray *data = g_byte_array_new();
+
+        /* reconstruct message log entries */
         for (int idx = 0; idx < cJSON_GetArraySize(obj); idx++)
         {
             cJSON *le = cJSON_GetArrayItem(obj, idx);
-            message_log_entry *entry = g_malloc(sizeof(message_log_entry));
+            guint last;
 
-            entry->gtime = cJSON_GetObjectItem(le, "gtime")->valueint;
-            entry->message = g_strdup(cJSON_GetObjectItem(le, "message")->valuestring);
+            g_byte_array_set_size(data, 0);
 
-            g_ptr_array_add(log->entries, entry);
+            if (log_messages_deserialize(log, cJSON_GetObjectItem(le, "messages"),
+                                         data, &last))
+            {
+                log_entry_add(log, cJSON_GetObjectItem(le, "gtime")->valueint,
+                              data->data, data->len);
+            }
         }
+
+        g_byte_array_free(data, TRUE);
     }
 
     return log;
@@ -483,7 +530,7 @@ int str_starts_with_vowel(const char *str)
 
 const char *int2str(int val)
 {
-    static char buf[21];
+    static THREAD_LOCAL char buf[21];
     const char *count_desc[] = { "no", "one", "two", "three", "four", "five",
                                  "six", "seven", "eight", "nine", "ten",
                                  "eleven", "twelve", "thirteen", "fourteen",
@@ -512,15 +559,419 @@ const char *int2time_str(int val)
     }
     else
     {
-        static char buf[21];
+        static THREAD_LOCAL char buf[21];
         g_snprintf(buf, 20, "%d times", val);
         return buf;
     }
 }
 
-static void log_entry_destroy(message_log_entry *entry)
+static void log_pack(message_log *log, const char *fmt, va_list argp)
+{
+    GByteArray *dest = log->pending;
+    const char *pos;
+    char spec[LOG_SPEC_MAX];
+    char conv;
+    guint16 id;
+
+    /* check if all conversions of the format string are supported */
+    for (pos = strchr(fmt, '%'); pos != NULL; pos = strchr(pos, '%'))
+    {
+        pos = log_conversion(pos, spec, &conv);
+
+        if (conv == 0)
+            break;
+    }
+
+    /* messages without arguments and those with unsupported
+       conversions are stored as text */
+    if (strchr(fmt, '%') == NULL)
+    {
+        id = LOG_TEXT_TEMPLATE;
+        g_byte_array_append(dest, (const guint8 *)&id, sizeof(id));
+        g_byte_array_append(dest, (const guint8 *)fmt, strlen(fmt) + 1);
+
+        return;
+    }
+
+    if (pos != NULL || (id = log_template_id(log, fmt)) == LOG_TEXT_TEMPLATE)
+    {
+        char *msg = g_strdup_vprintf(fmt, argp);
+
+        id = LOG_TEXT_TEMPLATE;
+        g_byte_array_append(dest, (const guint8 *)&id, sizeof(id));
+        g_byte_array_append(dest, (const guint8 *)msg, strlen(msg) + 1);
+        g_free(msg);
+
+        return;
+    }
+
+    g_byte_array_append(dest, (const guint8 *)&id, sizeof(id));
+
+    for (pos = strchr(fmt, '%'); pos != NULL; pos = strchr(pos, '%'))
+    {
+        pos = log_conversion(pos, spec, &conv);
+
+        switch (conv)
+        {
+        case 's':
+        {
+            const char *str = va_arg(argp, const char *);
+
+            if (str == NULL)
+                str = "(null)";
+
+            g_byte_array_append(dest, (const guint8 *)str, strlen(str) + 1);
+        }
+        break;
+
+        case 'c':
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        {
+            guint32 val = va_arg(argp, guint32);
+            g_byte_array_append(dest, (const guint8 *)&val, sizeof(val));
+        }
+        break;
+
+        default:
+            /* %% */
+            break;
+        }
+    }
+}
+
+/* compare the last two pending messages, which start at the given offsets */
+static gboolean log_pending_equal(message_log *log, guint first, guint second)
+{
+    const guint8 *data = log->pending->data;
+    const guint first_size = second - first;
+    const guint second_size = log->pending->len - second;
+
+    /* same format string and arguments */
+    if (first_size == second_size
+            && memcmp(data + first, data + second, first_size) == 0)
+    {
+        return TRUE;
+    }
+
+    /* different format strings may still result in the same text */
+    GString *first_text = g_string_new(NULL);
+    GString *second_text = g_string_new(NULL);
+
+    log_format(log, first_text, data + first, first_size);
+    log_format(log, second_text, data + second, second_size);
+
+    gboolean equal = (strcmp(first_text->str, second_text->str) == 0);
+
+    g_string_free(first_text, TRUE);
+    g_string_free(second_text, TRUE);
+
+    return equal;
+}
+
+static guint log_template_id(message_log *log, const char *fmt)
+{
+    gpointer id = g_hash_table_lookup(log->template_ids, fmt);
+
+    if (id != NULL)
+        return GPOINTER_TO_UINT(id) - 1;
+
+    /* the format strings are stored with 16 bits; format strings are
+       created at run time only from a limited set of texts, hence
+       this should never happen */
+    if (log->templates->len > G_MAXUINT16)
+        return LOG_TEXT_TEMPLATE;
+
+    char *tpl = g_strdup(fmt);
+    profile_alloc(PM_MESSAGE_LOG, strlen(tpl) + 1);
+
+    g_ptr_array_add(log->templates, tpl);
+    g_hash_table_insert(log->template_ids, tpl,
+                        GUINT_TO_POINTER(log->templates->len));
+
+    return log->templates->len - 1;
+}
+
+/*
+ * Parse a conversion specification which starts at fmt. The specification
+ * is copied to spec and its type stored in conv, which is 0 if the
+ * specification is not supported. Returns the position after the
+ * specification.
+ */
+static const char *log_conversion(const char *fmt, char *spec, char *conv)
+{
+    const char *pos = fmt + 1;
+
+    /* flags, field width and precision */
+    while (*pos && strchr("-+ #0", *pos))
+        pos++;
+
+    while (g_ascii_isdigit(*pos))
+        pos++;
+
+    if (*pos == '.')
+    {
+        pos++;
+
+        while (g_ascii_isdigit(*pos))
+            pos++;
+    }
+
+    if (*pos && strchr("%csdiux", *pos) && pos - fmt + 2 <= LOG_SPEC_MAX)
+    {
+        *conv = *pos;
+        pos++;
+
+        memcpy(spec, fmt, pos - fmt);
+        spec[pos - fmt] = '\0';
+    }
+    else
+    {
+        *conv = 0;
+
+        if (*pos)
+            pos++;
+    }
+
+    return pos;
+}
+
+static void log_format(message_log *log, GString *out,
+                       const guint8 *data, gsize size)
+{
+    const guint8 *end = data + size;
+    char spec[LOG_SPEC_MAX];
+    char conv;
+
+    while (data < end)
+    {
+        guint16 id;
+
+        memcpy(&id, data, sizeof(id));
+        data += sizeof(id);
+
+        const char *fmt = g_ptr_array_index(log->templates, id);
+
+        /* if there is already text, append a space first */
+        if (out->len)
+            g_string_append_c(out, ' ');
+
+        while (*fmt)
+        {
+            const char *next = strchr(fmt, '%');
+
+            if (next == NULL)
+            {
+                g_string_append(out, fmt);
+                break;
+            }
+
+            g_string_append_len(out, fmt, next - fmt);
+            fmt = log_conversion(next, spec, &conv);
+
+            if (conv == 's')
+            {
+                g_string_append_printf(out, spec, (const char *)data);
+                data += strlen((const char *)data) + 1;
+            }
+            else if (conv == '%')
+            {
+                g_string_append_c(out, '%');
+            }
+            else
+            {
+                guint32 val;
+
+                memcpy(&val, data, sizeof(val));
+                data += sizeof(val);
+
+                g_string_append_printf(out, spec, val);
+            }
+        }
+    }
+}
+
+static cJSON *log_messages_serialize(message_log *log,
+                                     const guint8 *data, gsize size)
+{
+    const guint8 *end = data + size;
+    cJSON *mser = cJSON_CreateArray();
+    char spec[LOG_SPEC_MAX];
+    char conv;
+
+    /* each message is stored as the number of the format string
+       followed by its arguments */
+    while (data < end)
+    {
+        cJSON *msg = cJSON_CreateArray();
+        guint16 id;
+
+        memcpy(&id, data, sizeof(id));
+        data += sizeof(id);
+
+        cJSON_AddItemToArray(mser, msg);
+        cJSON_AddItemToArray(msg, cJSON_CreateNumber(id));
+
+        const char *fmt = g_ptr_array_index(log->templates, id);
+
+        for (fmt = strchr(fmt, '%'); fmt != NULL; fmt = strchr(fmt, '%'))
+        {
+            fmt = log_conversion(fmt, spec, &conv);
+
+            if (conv == 's')
+            {
+                cJSON_AddItemToArray(msg, cJSON_CreateString((const char *)data));
+                data += strlen((const char *)data) + 1;
+            }
+            else if (conv != '%')
+            {
+                gint32 val;
+
+                memcpy(&val, data, sizeof(val));
+                data += sizeof(val);
+
+                cJSON_AddItemToArray(msg, cJSON_CreateNumber(val));
+            }
+        }
+    }
+
+    return mser;
+}
+
+static gboolean log_messages_deserialize(message_log *log, cJSON *mser,
+                                         GByteArray *dest, guint *last)
+{
+    char spec[LOG_SPEC_MAX];
+    char conv;
+
+    if (mser == NULL)
+        return FALSE;
+
+    for (int idx = 0; idx < cJSON_GetArraySize(mser); idx++)
+    {
+        cJSON *msg = cJSON_GetArrayItem(mser, idx);
+        guint16 id = cJSON_GetArrayItem(msg, 0)->valueint;
+        int arg = 1;
+
+        g_assert(id < log->templates->len);
+
+        *last = dest->len;
+        g_byte_array_append(dest, (const guint8 *)&id, sizeof(id));
+
+        const char *fmt = g_ptr_array_index(log->templates, id);
+
+        for (fmt = strchr(fmt, '%'); fmt != NULL; fmt = strchr(fmt, '%'))
+        {
+            fmt = log_conversion(fmt, spec, &conv);
+
+            if (conv == 's')
+            {
+                const char *str = cJSON_GetArrayItem(msg, arg++)->valuestring;
+                g_byte_array_append(dest, (const guint8 *)str, strlen(str) + 1);
+            }
+            else if (conv != '%')
+            {
+                gint32 val = cJSON_GetArrayItem(msg, arg++)->valueint;
+                g_byte_array_append(dest, (const guint8 *)&val, sizeof(val));
+            }
+        }
+    }
+
+    return (dest->len > 0);
+}
+
+static void log_entry_add(message_log *log, guint32 gtime,
+                          const guint8 *data, gsize size)
+{
+    message_log_chunk *chunk = log->tail;
+
+    /* assure the log does not grow too much */
+    if (log->count == LOG_MAX_LENGTH)
+        log_entry_remove(log);
+
+    /* start a new chunk if the messages do not fit into the current one */
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        if (log->spare != NULL && log->spare->size >= size)
+        {
+            chunk = log->spare;
+            log->spare = NULL;
+
+            chunk->next = NULL;
+            chunk->used = 0;
+            chunk->entries = 0;
+        }
+        else
+        {
+            chunk = log_chunk_new(MAX(LOG_CHUNK_SIZE, size));
+        }
+
+        if (log->tail != NULL)
+            log->tail->next = chunk;
+        else
+            log->head = chunk;
+
+        log->tail = chunk;
+    }
+
+    message_log_entry *entry = &log->entries[(log->first + log->count) % LOG_MAX_LENGTH];
+
+    entry->gtime = gtime;
+    entry->size = size;
+    entry->data = chunk->data + chunk->used;
+    memcpy(entry->data, data, size);
+
+    chunk->used += size;
+    chunk->entries++;
+    log->count++;
+}
+
+static void log_entry_remove(message_log *log)
+{
+    /* the messages of the oldest entry are always stored in the first chunk */
+    message_log_chunk *chunk = log->head;
+
+    g_assert(log->count > 0 && chunk != NULL);
+
+    log->first = (log->first + 1) % LOG_MAX_LENGTH;
+    log->count--;
+
+    if (--chunk->entries > 0)
+        return;
+
+    if (chunk == log->tail)
+    {
+        /* the only chunk can be filled again from the start */
+        chunk->used = 0;
+        return;
+    }
+
+    /* keep the chunk for reuse */
+    log->head = chunk->next;
+
+    if (log->spare != NULL)
+        log_chunk_free(log->spare);
+
+    log->spare = chunk;
+}
+
+static message_log_chunk *log_chunk_new(gsize size)
+{
+    message_log_chunk *chunk = g_malloc(sizeof(message_log_chunk) + size);
+    profile_alloc(PM_MESSAGE_LOG, sizeof(message_log_chunk) + size);
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->entries = 0;
+
+    return chunk;
+}
+
+static void log_chunk_free(message_log_chunk *chunk)
 {
-    g_assert(entry != NULL);
-    g_free(entry->message);
-    g_free(entry);
+    profile_free(PM_MESSAGE_LOG, sizeof(message_log_chunk) + chunk->size);
+    g_free(chunk);
 }
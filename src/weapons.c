@@ -73,10 +73,10 @@ const weapon_data weapons[WT_MAX] =
 };
 
 /* static functions */
-damage *weapon_get_ranged_damage(player *p, item *weapon, item *ammo);
-gboolean weapon_ammo_drop(map *m, item *ammo, const GList *traj);
+damage weapon_get_ranged_damage(player *p, item *weapon, item *ammo);
+gboolean weapon_ammo_drop(map *m, item *ammo, const position_span *traj, guint idx);
 
-static gboolean weapon_pos_hit(const GList *traj,
+static gboolean weapon_pos_hit(const position_span *traj, guint idx,
         const damage_originator *damo,
         gpointer data1, gpointer data2);
 
@@ -385,34 +385,36 @@ char *weapon_shortdesc(item *weapon, guint available_space)
     return g_string_free(desc, FALSE);
 }
 
-damage *weapon_get_ranged_damage(player *p, item *weapon, item *ammo)
+damage weapon_get_ranged_damage(player *p, item *weapon, item *ammo)
 {
     g_assert (p != NULL && weapon != NULL && ammo != NULL);
 
-    damage *dam = damage_new(DAM_PHYSICAL, ATT_WEAPON, 0, DAMO_PLAYER, p);
-    dam->amount = weapon_damage(weapon) + ammo_damage(ammo);
+    damage dam = damage_new(DAM_PHYSICAL, ATT_WEAPON, 0, DAMO_PLAYER, p);
+    dam.amount = weapon_damage(weapon) + ammo_damage(ammo);
 
     return dam;
 }
 
-gboolean weapon_ammo_drop(map *m, item *ammo, const GList *traj)
+gboolean weapon_ammo_drop(map *m, item *ammo, const position_span *traj, guint idx)
 {
-    /* Due to the recursive usage of this function traj may be NULL
-       (e.g. when the player is wall-walking and shooting at a xorn). */
-    if (traj == NULL)
-    {
-        item_destroy(ammo);
-        return TRUE;
-    }
-
-    position pos;
-    pos_val(pos) = GPOINTER_TO_UINT(traj->data);
+    position pos = traj->pos[idx];
     map_tile_t tt = map_tiletype_at(m, pos);
 
     /* If the ammo comes to stop on a solid tile it has to be dropped on
        the last tile that is not solid, i.e. the floor before a wall tile. */
     if (!map_pos_transparent(m, pos))
-        return weapon_ammo_drop(m, ammo, g_list_previous(traj));
+    {
+        /* Due to the recursive usage of this function there may be no
+           previous position (e.g. when the player is wall-walking and
+           shooting at a xorn). */
+        if (idx == 0)
+        {
+            item_destroy(ammo);
+            return TRUE;
+        }
+
+        return weapon_ammo_drop(m, ammo, traj, idx - 1);
+    }
 
     /* check if the ammo survives usage */
     if (chance(item_fragility(ammo) + 15)
@@ -425,13 +427,12 @@ gboolean weapon_ammo_drop(map *m, item *ammo, const GList *traj)
     return TRUE;
 }
 
-static gboolean weapon_pos_hit(const GList *traj,
+static gboolean weapon_pos_hit(const position_span *traj, guint idx,
         const damage_originator *damo __attribute__((unused)),
         gpointer data1,
         gpointer data2)
 {
-    position cpos;
-    pos_val(cpos) = GPOINTER_TO_UINT(traj->data);
+    position cpos = traj->pos[idx];
 
     map *cmap = game_map(nlarn, Z(cpos));
     item *weapon = (item *)data1;
@@ -451,7 +452,7 @@ static gboolean weapon_pos_hit(const GList *traj,
         if (chance(weapon_calc_to_hit(nlarn->p, m, weapon, ammo)))
         {
             /* hit */
-            damage *dam = weapon_get_ranged_damage(nlarn->p, weapon, ammo);
+            damage dam = weapon_get_ranged_damage(nlarn->p, weapon, ammo);
 
             if (monster_in_sight(m))
                 log_add_entry(nlarn->log, "%s hits the %s.",
@@ -459,7 +460,7 @@ static gboolean weapon_pos_hit(const GList *traj,
 
             monster_damage_take(m, dam);
 
-            ammo_handled = weapon_ammo_drop(cmap, ammo, traj);
+            ammo_handled = weapon_ammo_drop(cmap, ammo, traj, idx);
             retval = TRUE;
         }
         else
@@ -479,7 +480,7 @@ static gboolean weapon_pos_hit(const GList *traj,
     if (!ammo_handled && !map_pos_transparent(cmap, cpos))
     {
         /* The ammo hit some map feature -> stop its movement */
-        weapon_ammo_drop(cmap, ammo, traj);
+        weapon_ammo_drop(cmap, ammo, traj, idx);
 
         retval = TRUE;
     }